@@ -5,7 +5,8 @@ PredictDialog::PredictDialog(SDRunoPlugin_SatTrackForm& parent) :
 	nana::form(nana::API::make_center(630, 440), nana::appearance(true, false, true, false, false, false, false)),
 	m_parent(parent),
 	file_(parent.GetTLEFile()),
-	selections_(parent.GetSelections()) {
+	selections_(parent.GetSelections()),
+	predictor_(parent.GetPool()) {
 	Setup();
 }
 
@@ -54,7 +55,7 @@ void PredictDialog::Setup() {
 	lb_filter.transparent(true);
 	lb_filter.caption("Satellite elevation >");
 
-	sat_list_ = load_tle_file(m_parent.GetTLEFilesFolder() + file_);
+	catalog_.load({ m_parent.GetTLEFilesFolder() + file_ }, m_parent.GetPool());
 
 	filter_ = selections_["sat_elevation"].num_val();
 
@@ -65,13 +66,14 @@ void PredictDialog::Setup() {
 		selections_["sat_elevation"] = filter_;
 									});
 
-	for (auto& l : sat_list_) {
-		auto item = lb_select.at(0).append(l.first);
-		if (!selections_.contains_key(l.first)) {
-			selections_.add_pair(l.first, json_utils::json_value{ false });
+	for (size_t i = 0; i < catalog_.size(); i++) {
+		const std::string& name = catalog_.name(i);
+		auto item = lb_select.at(0).append(name);
+		if (!selections_.contains_key(name)) {
+			selections_.add_pair(name, json_utils::json_value{ false });
 		}
 		else
-			item->check(selections_[l.first].bool_val());
+			item->check(selections_[name].bool_val());
 	}
 	lb_select.events().checked([&](const nana::arg_listbox& ar_lbx) {
 		if (selections_.contains_key(ar_lbx.item.text(0))) {
@@ -84,160 +86,229 @@ void PredictDialog::Setup() {
 	prog_.bgcolor(nana::colors::black);
 	prog_.hide();
 
-	//btn_predict.events().click(nana::threads::pool_push(thrpool_, *this, &PredictDialog::Predict));
 	btn_predict.events().click([&] {
 		Predict();
 	});
 
-	events().unload([&] {
-
-		if (!canceled_.load())
-		{
-			canceled_ = true;
+	poll_.interval(std::chrono::milliseconds(40));
+	poll_.elapse([&] {
+		PollPredictions();
+	});
 
-			std::this_thread::sleep_for(std::chrono::seconds(1));
-		}
+	events().unload([&] {
+		poll_.stop();
+		predictor_.cancel();
+		predictor_.wait();
 					});
 }
 
-void PredictDialog::Predictions(const std::string& sat_name) {
-
-	if (!sat_list_.contains(sat_name))
-		return;
+void PredictDialog::Predict() {
+	results_.clear();
+	cached_.clear();
+	lb_predicts.clear();
 
-	line_pair tle_data = sat_list_[sat_name];
+	batch_.clear();
+	found_.pop_all(batch_);	// left by a canceled run
+	batch_.clear();
 
-	elsetrec satrec; /* Pointer to two-line elements set for satellite */
-	parse_tle_lines(tle_data, 'a', wgs72, satrec);
-	if (satrec.error)
+	auto sats = lb_select.checked();
+	if (sats.empty())
 		return;
 
-	bool geostationary = (int)((2.0 * M_PI) / satrec.no_kozai) == 1436;	// 1 sideral day : 23h 56mn 4.0905 s = 1436.068175 mn
-	if (geostationary)
-		return; // geostationary satellites are ignored
-
-	double start = julian_now();
-	double end = start + 1.0;	// 1 day predictions
-
-	double tle_date = satrec.jdsatepoch + satrec.jdsatepochF;
-	double rev_per_day = satrec.no_kozai * 1440 / (2.0 * M_PI);	// (rev/day)
-	double step = 1.0 / rev_per_day / 20.0; // coarse step 20 points per period
-
-	bool first = true;
-	double previous_elev = 0.0;
-
-	predict_results result{};
-	result.name = sat_name;
-
-	double jd = (tle_date > start) ? tle_date : start;
-	while (jd < end) {
-
-		auto [azimut, elevation] = calc_azm_elev(jd, observer_, satrec);
-		if (satrec.error != 0)
-			break;
+	predict_start_ = m_parent.GetClock().now();
+	predict_end_ = predict_start_ + 1.0;	// 1 day predictions
 
-		if (first) {
-			previous_elev = elevation;
-			jd += step;
-			first = false;
+	// the cached passes are shown at once, only the rest of the window is scanned
+	pass_cache_t& cache = m_parent.GetPassCache();
+	double min_elevation = to_rad(filter_);
+	min_elevation_ = min_elevation;
+	size_t never = 0;
 
+	predict_names_.clear();
+	scans_.clear();
+	std::vector<const sgp4_model*> models;
+	std::vector<double> starts;
+	std::vector<pass_t> cached;
+	for (const auto& sat : sats) {
+		std::string name = lb_select.at(sat).text(0);
+		size_t index = catalog_.find(name);
+		if (index == sat_catalog_t::npos)
 			continue;
-		}
 
-		if (elevation * previous_elev < 0.0) {	// zero crossing
-			if (previous_elev < elevation) {
-				result.jd_pass_start = regula_falsi(jd - step, jd, observer_, satrec);
-				if (result.jd_pass_start > 0) {
-					std::tie(result.azm_start, result.elev_start) = calc_azm_elev(result.jd_pass_start, observer_, satrec);
-				}
-			}
-			else {
-				if (result.jd_pass_start > 0) {
-
-					result.jd_pass_end = regula_falsi(jd - step, jd, observer_, satrec);
-					if (result.jd_pass_end > 0) {
-						std::tie(result.azm_end, result.elev_end) = calc_azm_elev(result.jd_pass_end, observer_, satrec);
-
-						result.jd_pass_max = (result.jd_pass_start + result.jd_pass_end) / 2.0;
-						std::tie(result.azm_max, result.elev_max) = calc_azm_elev(result.jd_pass_max, observer_, satrec);
-						if (satrec.error == 0) {
-							results_.insert(result);
-						}
-					}
-				}
-
-				result.jd_pass_start = 0;
-				result.jd_pass_end = 0;
-			}
+		uint32_t p = (uint32_t)predict_names_.size();
+		predict_names_.push_back(name);
+		if (!can_rise(catalog_.model(index), observer_, min_elevation))
+			never++;
+
+		pass_cache_t::key_t key{ catalog_.hash(index), observer_.geo.lat, observer_.geo.lon, observer_.geo.alt, min_elevation };
+		cached.clear();
+		cache.passes(key, predict_start_, predict_end_, cached);
+		for (const pass_t& pass : cached) {
+			if (pass.elev_max >= min_elevation)
+				cached_.push_back(pass_record_t{ pass, p });
 		}
 
-		previous_elev = elevation;
+		double from = cache.scan_from(key, predict_start_, predict_end_);
+		if (from >= predict_end_)
+			continue;
 
-		jd += step;
+		scans_.push_back(scan_t{ p, key, from, cached.empty() ? 0.0 : cached.back().jd_start + 1.0 / 86400.0 });
+		models.push_back(&catalog_.model(index));
+		starts.push_back(from);
 	}
 
-}
+	if (never > 0)
+		caption(std::format("SDRuno SatTrack Plugin - Predictions ({} of {} satellites never above {:.0f})", never, predict_names_.size(), filter_));
+	else
+		caption("SDRuno SatTrack Plugin - Predictions");
 
-void PredictDialog::Predict() {
-	results_.clear();
-	lb_predicts.clear();
+	std::sort(cached_.begin(), cached_.end(), [](const pass_record_t& a, const pass_record_t& b) {
+		return a.pass.jd_start < b.pass.jd_start;
+	});
+	ShowPredictions(cached_);
 
-	auto sats = lb_select.checked();
-	if (sats.empty())
+	if (models.empty()) {
+		EndPredictions();
 		return;
-
-	canceled_ = false;
+	}
 
 	tb_filter.enabled(false);
 	btn_predict.enabled(false);
 	prog_.show();
 
-	prog_.amount((int)sats.size());
+	prog_.amount((int)models.size());
 	prog_.value(0);
 
-	for (const auto& sat : sats) {
-		if (canceled_.load()) {
-			prog_.hide();
-			btn_predict.enabled(true);
-			tb_filter.enabled(true);
+	// the satellites are computed on the thread pool, the gui thread only polls
+	last_done_ = sat_catalog_t::npos;
+	predictor_.start(std::move(models), std::move(starts), observer_, predict_end_, min_elevation, [this](size_t sat, size_t, size_t) {
+		last_done_ = scans_[sat].sat;
+	}, [this, min_elevation](size_t sat, const pass_t& pass) {
+		const scan_t& scan = scans_[sat];
+		if (pass.elev_max >= min_elevation && pass.jd_start > scan.jd_cached)
+			found_.push(pass_record_t{ pass, scan.sat });
+	});
 
-			return;
-		}
+	poll_.start();
+}
+
+void PredictDialog::PollPredictions() {
+	prog_.value((int)predictor_.done());
+
+	size_t sat = last_done_.load();
+	if (sat != sat_catalog_t::npos)
+		prog_.caption(predict_names_[sat]);
 
-		std::string s = lb_select.at(sat).text(0);
-		prog_.inc();
-		prog_.caption(s);
-		Predictions(s);
+	// read before draining : the passes of a finished run are all in the queue
+	bool running = predictor_.running();
+
+	found_.pop_all(batch_);
+	if (!batch_.empty()) {
+		ShowPredictions(batch_);
+		batch_.clear();
 	}
 
-	prog_.amount((int)results_.size());
-	prog_.value(0);
+	if (running)
+		return;
 
-	for (auto& r : results_) {
-		if (canceled_.load()) {
-	prog_.hide();
-	btn_predict.enabled(true);
-	tb_filter.enabled(true);
+	poll_.stop();
+	EndPredictions();
+}
 
-			return;
-		}
+void PredictDialog::ShowPredictions(const std::vector<pass_record_t>& found) {
+	julian_formatter_t local_time(false);
+
+	lb_predicts.avoid_drawing([&] {
+		for (auto& f : found) {
+			// after the passes starting at the same date
+			auto it = std::upper_bound(results_.begin(), results_.end(), f, [](const pass_record_t& a, const pass_record_t& b) {
+				return a.pass.jd_start < b.pass.jd_start;
+			});
+			size_t row = 4 * (size_t)(it - results_.begin());
+			results_.insert(it, f);
 
-		prog_.inc();
-		prog_.caption(r.name);
-		if (to_deg(r.elev_max) >= filter_) {
-			lb_predicts.at(0).append({ julian_to_string(r.jd_pass_start, false), r.name, std::format("{:6.1f}",to_deg(r.azm_start)), std::format("{:6.1f}",to_deg(r.elev_start)) });
-			lb_predicts.at(0).append({ julian_to_string(r.jd_pass_max, false), r.name, std::format("{:6.1f}",to_deg(r.azm_max)), std::format("{:6.1f}",to_deg(r.elev_max)) });
-			lb_predicts.at(0).append({ julian_to_string(r.jd_pass_end, false), r.name, std::format("{:6.1f}",to_deg(r.azm_end)), std::format("{:6.1f}",to_deg(r.elev_end)) });
-			auto item = lb_predicts.at(0).append("");
-			item->bgcolor(nana::colors::dark_gray);
+			InsertPass(row, f, local_time);
 		}
+	});
+}
+
+void PredictDialog::InsertPass(size_t row, const pass_record_t& record, julian_formatter_t& local_time) {
+	const pass_t& r = record.pass;
+	const std::string& name = predict_names_[record.sat];
+	InsertRow(row++, { local_time.to_string(r.jd_start), name, std::format("{:6.1f}",to_deg(r.azm_start)), std::format("{:6.1f}",to_deg(r.elev_start)) });
+	InsertRow(row++, { local_time.to_string(r.jd_max), name, std::format("{:6.1f}",to_deg(r.azm_max)), std::format("{:6.1f}",to_deg(r.elev_max)) });
+	InsertRow(row++, { local_time.to_string(r.jd_end), name, std::format("{:6.1f}",to_deg(r.azm_end)), std::format("{:6.1f}",to_deg(r.elev_end)) });
+	auto item = InsertRow(row, { "" });
+	item.bgcolor(nana::colors::dark_gray);
+}
+
+nana::listbox::item_proxy PredictDialog::InsertRow(size_t row, std::initializer_list<std::string> cells) {
+	auto cat = lb_predicts.at(0);
+	auto cell = cells.begin();
+
+	// insert_item only inserts before an existing row
+	if (row < cat.size())
+		lb_predicts.insert_item(nana::listbox::index_pair(0, row), *cell);
+	else {
+		row = cat.size();
+		cat.push_back(*cell);
+	}
+
+	auto item = cat.at(row);
+	for (size_t col = 1; ++cell != cells.end(); col++) {
+		item.text(col, *cell);
 	}
 
+	return item;
+}
+
+void PredictDialog::EndPredictions() {
 	prog_.hide();
 	btn_predict.enabled(true);
 	tb_filter.enabled(true);
 
-	canceled_ = true;
-}
+	if (scans_.empty())
+		return;
 
+	// the rows came in as the workers found them, passes at the same date in no fixed
+	// order : the table is rebuilt from the cached passes and the merged runs
+	predictor_.merge(merged_);
+	std::erase_if(merged_, [this](pass_record_t& record) {
+		const scan_t& scan = scans_[record.sat];
+		record.sat = scan.sat;
+
+		return record.pass.elev_max < min_elevation_ || record.pass.jd_start <= scan.jd_cached;
+	});
+	merge_passes({ cached_, merged_ }, results_);
 
+	julian_formatter_t local_time(false);
+	lb_predicts.avoid_drawing([&] {
+		lb_predicts.clear();
+		for (size_t i = 0; i < results_.size(); i++) {
+			InsertPass(4 * i, results_[i], local_time);
+		}
+	});
+
+	// a canceled run only knows part of its window
+	if (predictor_.canceled())
+		return;
+
+	pass_cache_t& cache = m_parent.GetPassCache();
+	std::vector<pass_t> passes;
+	for (size_t i = 0; i < scans_.size(); i++) {
+		double known = predictor_.known(i);
+		if (known <= 0.0)
+			continue;
+
+		passes.clear();
+		for (const pass_record_t& record : predictor_.passes(i)) {
+			passes.push_back(record.pass);
+		}
+
+		const scan_t& scan = scans_[i];
+		cache.store(scan.key, predict_names_[scan.sat], predict_start_, scan.jd_from, predict_end_, known, passes);
+	}
+	scans_.clear();
+
+	m_parent.SavePassCache();
+}
@@ -3,7 +3,8 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
-#include <set>
+#include <vector>
+#include <algorithm>
 
 #include <nana/gui.hpp>
 #include <nana/gui/widgets/button.hpp>
@@ -13,10 +14,15 @@
 #include <nana/gui/widgets/textbox.hpp>
 #include <nana/gui/widgets/checkbox.hpp>
 #include <nana/gui/widgets/progress.hpp>
-#include <nana/threads/pool.hpp>
+#include <nana/gui/timer.hpp>
 
 #include "sat_tools.h"
 #include "sat_calc.h"
+#include "sgp4_batch.h"
+#include "sat_catalog.h"
+#include "pass_predictor.h"
+#include "pass_cache.h"
+#include "mpsc_queue.h"
 
 class SDRunoPlugin_SatTrackForm;
 
@@ -29,41 +35,56 @@ public:
 private:
 	void Setup();
 
-	struct predict_results {
-		double jd_pass_start;
-		double jd_pass_max;
-		double jd_pass_end;
-
-		double azm_start;
-		double azm_max;
-		double azm_end;
-
-		double elev_start;
-		double elev_max;
-		double elev_end;
-		std::string name;
-
-		bool operator==(const predict_results& rhs) const {
-			return (jd_pass_start == rhs.jd_pass_start);
-		}
-		bool operator<(const predict_results& rhs) const {
-			return jd_pass_start < rhs.jd_pass_start;
-		}
-	};
-
 	void Predict();
-	void Predictions(const std::string& sat_name);
+
+	// progress of the running predictions, moves the passes found since the last poll to the table
+	void PollPredictions();
+	void ShowPredictions(const std::vector<pass_record_t>& found);
+	void EndPredictions();
+
+	// the 4 rows of a pass at row of lb_predicts
+	void InsertPass(size_t row, const pass_record_t& record, julian_formatter_t& local_time);
+
+	// row of lb_predicts at row, appended past the last one
+	nana::listbox::item_proxy InsertRow(size_t row, std::initializer_list<std::string> cells);
 
 	std::string file_;
 	json_utils::json_value& selections_;
-	std::map<std::string, line_pair> sat_list_;
+	sat_catalog_t catalog_;
 	observer_t observer_;
 	double filter_{};
 
-	//nana::threads::pool thrpool_;
-	std::atomic_bool canceled_ = false;
+	// passes in the table, by start date : 4 rows each. sat indexes predict_names_
+	std::vector<pass_record_t> results_;
+
+	// passes of results_ read from the cache, by start date, then the passes of predictor_
+	// merged at the end of the run : results_ is rebuilt from both
+	std::vector<pass_record_t> cached_;
+	std::vector<pass_record_t> merged_;
+
+	// satellites of the predictions, cached or not
+	std::vector<std::string> predict_names_;
+	std::atomic<size_t> last_done_{};
+	double predict_start_{};
+	double predict_end_{};
+	double min_elevation_{};
+
+	// satellites the cache does not cover, in the order given to predictor_. Read by its jobs
+	struct scan_t {
+		uint32_t sat;	// in predict_names_
+		pass_cache_t::key_t key;
+		double jd_from;		// start of the scan
+		double jd_cached;	// passes starting before are in the table already
+	};
+	std::vector<scan_t> scans_;
+
+	// passes above the filter pushed by the workers, drained by PollPredictions
+	mpsc_queue_t<pass_record_t> found_;
+	std::vector<pass_record_t> batch_;
 
-	std::multiset<predict_results> results_;
+	// destroyed first : its jobs read catalog_, scans_, last_done_ and found_
+	pass_predictor_t predictor_;
+	nana::timer poll_;
 
 	nana::listbox lb_predicts{ *this, {10,10,415,380} };
 	nana::listbox lb_select{ *this, {430,10,190,380} };
@@ -90,7 +90,7 @@ void SDRunoPlugin_SatTrackForm::Setup() {
 	nana::size window_map_size = sattrack_widget::calc_window_size(GetMapSize());
 
 	formWidth = window_map_size.width + (2 * sideBorderWidth);
-	formHeight = window_map_size.height + topBarHeight + bottomBarHeight;
+	formHeight = window_map_size.height + upcomingBarHeight + topBarHeight + bottomBarHeight;
 
 	// This first section is all related to the background and border
 	// it shouldn't need to be changed
@@ -200,18 +200,32 @@ void SDRunoPlugin_SatTrackForm::Setup() {
 	sattrack_ctrl.set_map(GetMapSize(), maps_dirs_);
 	sattrack_ctrl.set_downlink_freq(GetDownlinkFreq() * 1000000.0);
 	sattrack_ctrl.set_site(GetLocationName(), GetLatitude(), GetLongitude(), GetElevation());
+	sattrack_ctrl.set_clock(clock_);
+
+	upcoming_lbl.move(nana::rectangle(sideBorderWidth, topBarHeight + (int)window_map_size.height, window_map_size.width - 45, upcomingBarHeight));
+	upcoming_lbl.fgcolor(nana::colors::white);
+	upcoming_lbl.transparent(true);
+	upcoming_lbl.text_align(nana::align::left, nana::align_v::center);
 
 	SatChanged();
 
-	dopplerTimer_.interval(std::chrono::milliseconds(1000));
+	// the correction is computed at each tick, a short period keeps the frequency steps small
+	dopplerTimer_.interval(std::chrono::milliseconds(250));
 	dopplerTimer_.elapse([&] {
 		DopplerTick();
 	});
 	dopplerTimer_.start();
+
+	upcomingTimer_.interval(std::chrono::milliseconds(1000));
+	upcomingTimer_.elapse([&] {
+		UpcomingTick();
+	});
+	upcomingTimer_.start();
 }
 
 void SDRunoPlugin_SatTrackForm::SatChanged() {
 	sattrack_ctrl.stop();
+	upcoming_.reset();
 
 	if (!std::filesystem::exists(tle_files_dirs_ + GetTLEFile())) {
 		nana::msgbox mb(*this, "SDRunoPlugin_SatTrackForm");
@@ -219,14 +233,17 @@ void SDRunoPlugin_SatTrackForm::SatChanged() {
 		mb.show();
 	}
 	else {
-		tle_map_list sat_list = load_tle_file(tle_files_dirs_ + GetTLEFile());
-		if (sat_list.contains(GetSatName())) {
-			line_pair tle_data = sat_list[GetSatName()];
-			elsetrec satrec{};
-			parse_tle_lines(tle_data, 'a', wgs72, satrec);
-			if (!satrec.error) {
-				sattrack_ctrl.set_satellite(GetSatName(), satrec);
-			}
+		std::string filename = tle_files_dirs_ + GetTLEFile();
+		auto file_time = std::filesystem::last_write_time(filename);
+		if (filename != catalog_file_ || file_time != catalog_time_) {
+			catalog_.load({ filename }, GetPool());
+			catalog_file_ = filename;
+			catalog_time_ = file_time;
+		}
+
+		size_t index = catalog_.find(GetSatName());
+		if (index != sat_catalog_t::npos) {
+			sattrack_ctrl.set_satellite(GetSatName(), std::make_shared<const sgp4_model>(catalog_.model(index)));
 		}
 	}
 
@@ -267,6 +284,8 @@ void SDRunoPlugin_SatTrackForm::SetDatasFolder(const std::string& name) {
 	tle_files_dirs_ = data_dir_ + "tle\\";
 	tle_list_ = tle_files_dirs_ + TLE_LIST;
 	config_file_ = tle_files_dirs_ + CONFIG_FILE;
+	pass_cache_file_ = tle_files_dirs_ + PASS_CACHE_FILE;
+	pass_cache_loaded_ = false;
 
 	m_controller.SetConfigurationKey("SatTrack.DatasFolder", data_dir_);
 
@@ -298,6 +317,7 @@ void SDRunoPlugin_SatTrackForm::SetLatitude(double value) {
 	auto& loc = config_["location"];
 
 	loc["latitude"] = value;
+	upcoming_.reset();
 
 	sattrack_ctrl.set_site(loc["name"].str_val(), value, loc["longitude"].num_val(), loc["elevation"].num_val());
 }
@@ -306,6 +326,7 @@ void SDRunoPlugin_SatTrackForm::SetLongitude(double value) {
 	auto& loc = config_["location"];
 
 	loc["longitude"] = value;
+	upcoming_.reset();
 
 	sattrack_ctrl.set_site(loc["name"].str_val(), loc["latitude"].num_val(), value, loc["elevation"].num_val());
 }
@@ -315,6 +336,7 @@ void SDRunoPlugin_SatTrackForm::SetElevation(double value) {
 	auto& loc = config_["location"];
 
 	loc["elevation"] = value;
+	upcoming_.reset();
 
 	sattrack_ctrl.set_site(loc["name"].str_val(), loc["latitude"].num_val(), loc["longitude"].num_val(), value);
 }
@@ -425,6 +447,28 @@ json_utils::json_value& SDRunoPlugin_SatTrackForm::GetSelections() {
 	return config_["selections"];
 	}
 
+void SDRunoPlugin_SatTrackForm::SelectionsChanged() {
+	upcoming_.reset();
+}
+
+thread_pool_t& SDRunoPlugin_SatTrackForm::GetPool() {
+	return m_parent.GetPool();
+}
+
+pass_cache_t& SDRunoPlugin_SatTrackForm::GetPassCache() {
+	if (!pass_cache_loaded_) {
+		pass_cache_.load(pass_cache_file_);	// starts empty when there is none yet
+		pass_cache_loaded_ = true;
+	}
+
+	return pass_cache_;
+}
+
+void SDRunoPlugin_SatTrackForm::SavePassCache() {
+	if (pass_cache_loaded_ && pass_cache_.dirty())
+		pass_cache_.save(pass_cache_file_);
+}
+
 void SDRunoPlugin_SatTrackForm::LoadSettings() 	{
 	std::string tmp;
 
@@ -449,6 +493,8 @@ void SDRunoPlugin_SatTrackForm::LoadSettings() 	{
 	tle_files_dirs_ = data_dir_ + "tle\\";
 	tle_list_ = tle_files_dirs_ + TLE_LIST;
 	config_file_ = tle_files_dirs_ + CONFIG_FILE;
+	pass_cache_file_ = tle_files_dirs_ + PASS_CACHE_FILE;
+	pass_cache_loaded_ = false;
 
 	if (!std::filesystem::exists(config_file_)) {
 		create_default_config(config_file_);
@@ -536,7 +582,7 @@ void SDRunoPlugin_SatTrackForm::ResizeWindow(e_map_type map_type) {
 
 	nana::size window_map_size = sattrack_widget::calc_window_size(map_type);
 	formWidth = window_map_size.width + (2 * sideBorderWidth);
-	formHeight = window_map_size.height + topBarHeight + bottomBarHeight;
+	formHeight = window_map_size.height + upcomingBarHeight + topBarHeight + bottomBarHeight;
 
 	size(nana::size(formWidth, formHeight));
 
@@ -556,6 +602,8 @@ void SDRunoPlugin_SatTrackForm::ResizeWindow(e_map_type map_type) {
 
 	close_button.move(nana::point(formWidth - 26, 9));
 
+	upcoming_lbl.move(nana::rectangle(sideBorderWidth, topBarHeight + (int)window_map_size.height, window_map_size.width - 45, upcomingBarHeight));
+
 	sattrack_ctrl.set_map(GetMapSize(), maps_dirs_);
 }
 
@@ -581,4 +629,74 @@ void SDRunoPlugin_SatTrackForm::DopplerTick() {
 	double freq = sattrack_ctrl.get_doppler_correction_hz();
 
 	m_controller.SetVfoFrequency(0, freq);
+}
+
+void SDRunoPlugin_SatTrackForm::UpcomingTick() {
+	const size_t count = 3;
+
+	double now = clock_.now();
+
+	// built again once the clock left the window, or when less than a day is left
+	if (upcoming_ && (now < upcoming_start_ || now > upcoming_end_ - 1.0))
+		upcoming_.reset();
+
+	if (!upcoming_) {
+		auto& selections = GetSelections();
+
+		upcoming_names_.clear();
+		std::vector<const sgp4_model*> models;
+		for (size_t i = 0; i < catalog_.size(); i++) {
+			const std::string& name = catalog_.name(i);
+			if (selections.contains_key(name) && selections[name].is_boolean() && selections[name].bool_val()) {
+				upcoming_names_.push_back(name);
+				models.push_back(&catalog_.model(i));
+			}
+		}
+
+		if (models.empty()) {
+			size_t index = catalog_.find(GetSatName());
+			if (index != sat_catalog_t::npos) {
+				upcoming_names_.push_back(GetSatName());
+				models.push_back(&catalog_.model(index));
+			}
+		}
+
+		double min_elevation = selections.contains_key("sat_elevation") ? to_rad(selections["sat_elevation"].num_val()) : 0.0;
+
+		observer_t observer;
+		observer.reset(to_rad(GetLatitude()), to_rad(GetLongitude()), GetElevation() / 1000.0);
+
+		// from 1 hour ago for the passes in progress
+		upcoming_start_ = now - 1.0 / 24.0;
+		upcoming_end_ = now + 2.0;
+		upcoming_ = std::make_unique<pass_generator_t>(std::move(models), observer, upcoming_start_, upcoming_end_, min_elevation);
+		upcoming_passes_.clear();
+	}
+
+	std::erase_if(upcoming_passes_, [&](const pass_record_t& r) {
+		return r.pass.jd_end < now;
+	});
+
+	pass_record_t next;
+	while (upcoming_passes_.size() < count && upcoming_->next(next)) {
+		if (next.pass.jd_end >= now)
+			upcoming_passes_.push_back(next);
+	}
+
+	std::string text;
+	for (const pass_record_t& r : upcoming_passes_) {
+		if (!text.empty())
+			text += "   ";
+
+		int mn = (int)std::ceil((r.pass.jd_start - now) * 1440.0);
+		if (mn <= 0)
+			text += std::format("{} now", upcoming_names_[r.sat]);
+		else if (mn < 60)
+			text += std::format("{} in {} mn", upcoming_names_[r.sat], mn);
+		else
+			text += std::format("{} in {} h {:02}", upcoming_names_[r.sat], mn / 60, mn % 60);
+		text += std::format(" ({:.0f})", to_deg(r.pass.elev_max));
+	}
+
+	upcoming_lbl.caption(text);
 }
\ No newline at end of file
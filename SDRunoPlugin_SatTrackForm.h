@@ -13,16 +13,23 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <filesystem>
+#include <memory>
+#include <vector>
 
 #include <iunoplugincontroller.h>
 
 #include "sat_tools.h"
+#include "sat_catalog.h"
 #include "sattrack_widget.h"
+#include "pass_predictor.h"
+#include "pass_cache.h"
 
 // Shouldn't need to change these
 #define topBarHeight (27)
 #define bottomBarHeight (8)
 #define sideBorderWidth (8)
+#define upcomingBarHeight (18)
 
 // TODO: Change these numbers to the height and width of your form
 #define default_formWidth (500)
@@ -130,9 +137,24 @@ public:
 
 	json_utils::json_value& GetSelections();
 
+	// date of the tracking, the Doppler correction and the predictions
+	sat_clock_t& GetClock() {
+		return clock_;
+	}
+
 	void SavePos();
 	void LoadPos();
 
+	// the satellites selected for the predictions changed
+	void SelectionsChanged();
+
+	// worker threads of the plugin, for the catalog loading and the predictions
+	thread_pool_t& GetPool();
+
+	// passes of the former predictions, read from the datas folder on first use
+	pass_cache_t& GetPassCache();
+	void SavePassCache();
+
 private:
 
 	// settings
@@ -142,6 +164,7 @@ private:
 
 	std::string tle_list_{};
 	std::string config_file_{};
+	std::string pass_cache_file_{};
 
 	json_utils::json_value config_{};
 
@@ -153,15 +176,37 @@ private:
 	int predictX_{};
 	int predictY_{};
 
+	sat_clock_t& clock_{ sat_clock_t::shared() };
+
 	nana::timer dopplerTimer_;
 	void DopplerTick();
 
+	// next passes of the satellites selected for the predictions, or of the tracked one
+	// when none is, drawn from the generator as the earlier ones end. upcoming_ points
+	// in catalog_ : reset when it is loaded again, or when the site changes
+	nana::timer upcomingTimer_;
+	void UpcomingTick();
+
+	std::unique_ptr<pass_generator_t> upcoming_;
+	std::vector<std::string> upcoming_names_;
+	std::vector<pass_record_t> upcoming_passes_;
+	double upcoming_start_{};
+	double upcoming_end_{};
+
 	void Setup();
 	void LoadSettings();
 	void ResizeWindow(e_map_type map_type);
 
 	void SatChanged();
 
+	// satellites of the current tle file, only loaded again when the file changes
+	sat_catalog_t catalog_;
+	std::string catalog_file_{};
+	std::filesystem::file_time_type catalog_time_{};
+
+	pass_cache_t pass_cache_;
+	bool pass_cache_loaded_{};
+
 	// The following is to set up the panel graphic to look like a standard SDRuno panel
 	nana::picture bg_border{ *this, nana::rectangle(0, 0, default_formWidth, default_formHeight) };
 	nana::picture bg_inner{ bg_border, nana::rectangle(sideBorderWidth, topBarHeight, default_formWidth - (2 * sideBorderWidth), default_formHeight - topBarHeight - bottomBarHeight) };
@@ -188,6 +233,7 @@ private:
 	// TODO: Now add your UI controls here
 
 	sattrack_widget sattrack_ctrl{ *this, "", {sideBorderWidth, topBarHeight}, e_map_type::small_size};
+	nana::label upcoming_lbl{ *this, true };
 
 	SDRunoPlugin_SatTrackUI& m_parent;
 	IUnoPluginController& m_controller;
@@ -314,4 +314,6 @@ void SDRunoPlugin_SatTrackSettingsDialog::PredictButton_Click() {
 void SDRunoPlugin_SatTrackSettingsDialog::PredictDialog_Closed() {
 	this->enabled(true);
 	this->focus();
+
+	m_parent.SelectionsChanged();
 }
\ No newline at end of file
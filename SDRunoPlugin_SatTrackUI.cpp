@@ -23,6 +23,11 @@ SDRunoPlugin_SatTrackUI::SDRunoPlugin_SatTrackUI(SDRunoPlugin_SatTrack& parent,
 SDRunoPlugin_SatTrackUI::~SDRunoPlugin_SatTrackUI() {
 	nana::API::exit_all();
 	m_thread.join();
+
+	// the form cancels and waits for its jobs, then the workers are joined here,
+	// while the plugin code is still loaded
+	m_form.reset();
+	m_pool.stop();
 }
 
 // Show and execute the form
@@ -11,6 +11,7 @@
 
 #include <iunoplugincontroller.h>
 #include "SDRunoPlugin_SatTrackForm.h"
+#include "thread_pool.h"
 
 // Forward reference
 class SDRunoPlugin_SatTrack;
@@ -26,9 +27,15 @@ public:
 
 	void ShowUi();
 
+	thread_pool_t& GetPool() {
+		return m_pool;
+	}
+
 private:
 
 	SDRunoPlugin_SatTrack& m_parent;
+	// before m_form : its predictions run on the pool until it is destroyed
+	thread_pool_t m_pool;
 	std::thread m_thread;
 	std::shared_ptr<SDRunoPlugin_SatTrackForm> m_form;
 
@@ -57,6 +57,8 @@
 
 #include "SGP4.h"
 
+#include <atomic>
+
 #define pi 3.14159265358979323846
 
 // define global variables here, not in .h
@@ -233,7 +235,7 @@ namespace SGP4Funcs
 		double zmol, double zmos, double inclo,
 		char init,
 		double& ep, double& inclp, double& nodep, double& argpp, double& mp,
-		char opsmode
+		char opsmode, const sgp4_lunarsolar* ls = nullptr
 		)
 	{
 		/* --------------------- local variables ------------------------ */
@@ -242,7 +244,7 @@ namespace SGP4Funcs
 			f2, f3, pe, pgh, ph, pinc, pl,
 			sel, ses, sghl, sghs, shll, shs, sil,
 			sinip, sinop, sinzf, sis, sll, sls, xls,
-			xnoh, zf, zm, zel, zes, znl, zns;
+			xnoh, zf, zm, zel, zes, znl, zns, dzm;
 
 		/* ---------------------- constants ----------------------------- */
 		zns = 1.19459e-5;
@@ -251,26 +253,52 @@ namespace SGP4Funcs
 		zel = 0.05490;
 
 		/* --------------- calculate time varying periodics ----------- */
-		zm = zmos + zns * t;
-		// be sure that the initial call has time set to zero
-		if (init == 'y')
-			zm = zmos;
-		zf = zm + 2.0 * zes * sin(zm);
-		sinzf = sin(zf);
-		f2 = 0.5 * sinzf * sinzf - 0.25;
-		f3 = -0.5 * sinzf * cos(zf);
+		// the sun and moon terms only depend on the time, they are taken from ls
+		// when the caller computed them once for several satellites. ls is
+		// evaluated at the anomaly of the date, moved to the one of this satellite
+		// at first order
+		if (ls)
+		{
+			dzm = zmos + zns * t - ls->zms;
+			dzm = dzm - twopi * floor(dzm / twopi + 0.5);
+			sinzf = ls->sinzfs + ls->dsinzfs * dzm;
+			f2 = ls->f2s + ls->df2s * dzm;
+			f3 = ls->f3s + ls->df3s * dzm;
+		}
+		else
+		{
+			zm = zmos + zns * t;
+			// be sure that the initial call has time set to zero
+			if (init == 'y')
+				zm = zmos;
+			zf = zm + 2.0 * zes * sin(zm);
+			sinzf = sin(zf);
+			f2 = 0.5 * sinzf * sinzf - 0.25;
+			f3 = -0.5 * sinzf * cos(zf);
+		}
 		ses = se2* f2 + se3 * f3;
 		sis = si2 * f2 + si3 * f3;
 		sls = sl2 * f2 + sl3 * f3 + sl4 * sinzf;
 		sghs = sgh2 * f2 + sgh3 * f3 + sgh4 * sinzf;
 		shs = sh2 * f2 + sh3 * f3;
-		zm = zmol + znl * t;
-		if (init == 'y')
-			zm = zmol;
-		zf = zm + 2.0 * zel * sin(zm);
-		sinzf = sin(zf);
-		f2 = 0.5 * sinzf * sinzf - 0.25;
-		f3 = -0.5 * sinzf * cos(zf);
+		if (ls)
+		{
+			dzm = zmol + znl * t - ls->zml;
+			dzm = dzm - twopi * floor(dzm / twopi + 0.5);
+			sinzf = ls->sinzfl + ls->dsinzfl * dzm;
+			f2 = ls->f2l + ls->df2l * dzm;
+			f3 = ls->f3l + ls->df3l * dzm;
+		}
+		else
+		{
+			zm = zmol + znl * t;
+			if (init == 'y')
+				zm = zmol;
+			zf = zm + 2.0 * zel * sin(zm);
+			sinzf = sin(zf);
+			f2 = 0.5 * sinzf * sinzf - 0.25;
+			f3 = -0.5 * sinzf * cos(zf);
+		}
 		sel = ee2 * f2 + e3 * f3;
 		sil = xi2 * f2 + xi3 * f3;
 		sll = xl2 * f2 + xl3 * f3 + xl4 * sinzf;
@@ -962,6 +990,7 @@ namespace SGP4Funcs
 	*    mm          - mean anomaly
 	*    xni         - mean motion
 	*    nodem       - right ascension of ascending node
+	*    checkpoints - integrator steps already computed, may be null
 	*
 	*  outputs       :
 	*    atime       -
@@ -974,6 +1003,7 @@ namespace SGP4Funcs
 	*    nodem       - right ascension of ascending node
 	*    dndt        -
 	*    nm          - mean motion
+	*    checkpoints - completed with the new integrator steps
 	*
 	*  locals        :
 	*    delt        -
@@ -1007,7 +1037,8 @@ namespace SGP4Funcs
 		double t, double tc, double gsto, double xfact, double xlamo,
 		double no,
 		double& atime, double& em, double& argpm, double& inclm, double& xli,
-		double& mm, double& xni, double& nodem, double& dndt, double& nm
+		double& mm, double& xni, double& nodem, double& dndt, double& nm,
+		sgp4_dscheckpoints* checkpoints
 		)
 	{
 		const double twopi = 2.0 * pi;
@@ -1070,6 +1101,25 @@ namespace SGP4Funcs
 			else
 				delt = stepn;
 
+			// resume from the last checkpoint before t when it is ahead of atime,
+			// the steps are exact multiples of 720 min so the result is unchanged
+			if (checkpoints)
+			{
+				std::vector<double>& xlis = (t > 0.0) ? checkpoints->xlipos : checkpoints->xlineg;
+				std::vector<double>& xnis = (t > 0.0) ? checkpoints->xnipos : checkpoints->xnineg;
+				size_t k = (size_t)(fabs(t) / stepp);
+				if (k > xlis.size())
+					k = xlis.size();
+				while ((k > 0) && (k * stepp > fabs(t)))
+					k--;
+				if (k * stepp > fabs(atime))
+				{
+					atime = k * delt;
+					xli = xlis[k - 1];
+					xni = xnis[k - 1];
+				}
+			}
+
 			iretn = 381; // added for do loop
 			iret = 0; // added for loop
 			while (iretn == 381)
@@ -1125,6 +1175,17 @@ namespace SGP4Funcs
 					xli = xli + xldot * delt + xndt * step2;
 					xni = xni + xndt * delt + xnddt * step2;
 					atime = atime + delt;
+
+					if (checkpoints)
+					{
+						std::vector<double>& xlis = (t > 0.0) ? checkpoints->xlipos : checkpoints->xlineg;
+						std::vector<double>& xnis = (t > 0.0) ? checkpoints->xnipos : checkpoints->xnineg;
+						if ((size_t)(fabs(atime) / stepp) == xlis.size() + 1)
+						{
+							xlis.push_back(xli);
+							xnis.push_back(xni);
+						}
+					}
 				}
 			}  // while iretn = 381
 
@@ -1743,10 +1804,109 @@ namespace SGP4Funcs
 	*    vallado, crawford, hujsak, kelso  2006
 	----------------------------------------------------------------------------*/
 
-	bool sgp4
+	// integrator checkpoints are only kept in a sgp4_state
+	static sgp4_dscheckpoints* dscheckpointsof(elsetrec&)
+	{
+		return nullptr;
+	}
+
+	static sgp4_dscheckpoints* dscheckpointsof(sgp4_state& state)
+	{
+		return &state.checkpoints;
+	}
+
+	static unsigned long long dsserialof(const elsetrec&)
+	{
+		return 0;
+	}
+
+	static unsigned long long dsserialof(const elsetrec_deep& deeprec)
+	{
+		return deeprec.serial;
+	}
+
+	// serial of a newly filled deep block, never 0
+	static unsigned long long newdsserial()
+	{
+		static std::atomic<unsigned long long> last{ 0 };
+		return ++last;
+	}
+
+	/* -----------------------------------------------------------------------------
+	*
+	*                      sgp4 gravity constants and configurations
+	*
+	*  sgp4gravconst holds the getgravconst values as compile time constants, xke is
+	*    written out as the double getgravconst computes so both paths agree to the
+	*    last bit. a configuration tells sgp4core where to take the gravity constants,
+	*    the opsmode and the method from : sgp4runtimeconfig reads them from the record
+	*    at each call, sgp4fixedconfig has them fixed, which removes the loads and lets
+	*    the compiler drop the branches of the other method.
+	*
+	  ---------------------------------------------------------------------------- */
+
+	template <gravconsttype whichconst> struct sgp4gravconst;
+
+	template <> struct sgp4gravconst<wgs72old>
+	{
+		static constexpr double radiusearthkm = 6378.135, xke = 0.0743669161,
+			j2 = 0.001082616, j3 = -0.00000253881, j3oj2 = j3 / j2;
+	};
+
+	template <> struct sgp4gravconst<wgs72>
+	{
+		static constexpr double radiusearthkm = 6378.135, xke = 0.07436691613317342,
+			j2 = 0.001082616, j3 = -0.00000253881, j3oj2 = j3 / j2;
+	};
+
+	template <> struct sgp4gravconst<wgs84>
+	{
+		static constexpr double radiusearthkm = 6378.137, xke = 0.07436685316871385,
+			j2 = 0.00108262998905, j3 = -0.00000253215306, j3oj2 = j3 / j2;
+	};
+
+	struct sgp4runtimeconfig
+	{
+		template <class rec_t> static double radiusearthkm(const rec_t& satrec) { return satrec.radiusearthkm; }
+		template <class rec_t> static double xke(const rec_t& satrec) { return satrec.xke; }
+		template <class rec_t> static double j2(const rec_t& satrec) { return satrec.j2; }
+		template <class rec_t> static double j3oj2(const rec_t& satrec) { return satrec.j3oj2; }
+		template <class rec_t> static char opsmode(const rec_t& satrec) { return satrec.operationmode; }
+		template <class rec_t> static char method(const rec_t& satrec) { return satrec.method; }
+	};
+
+	template <gravconsttype whichconst, char opsmodec, char methodc>
+	struct sgp4fixedconfig
+	{
+		typedef sgp4gravconst<whichconst> gc;
+
+		template <class rec_t> static constexpr double radiusearthkm(const rec_t&) { return gc::radiusearthkm; }
+		template <class rec_t> static constexpr double xke(const rec_t&) { return gc::xke; }
+		template <class rec_t> static constexpr double j2(const rec_t&) { return gc::j2; }
+		template <class rec_t> static constexpr double j3oj2(const rec_t&) { return gc::j3oj2; }
+		template <class rec_t> static constexpr char opsmode(const rec_t&) { return opsmodec; }
+		template <class rec_t> static constexpr char method(const rec_t&) { return methodc; }
+	};
+
+	// true when the record was initialized with the whichconst constants
+	template <gravconsttype whichconst, class rec_t>
+	static bool hasgravconst(const rec_t& satrec)
+	{
+		typedef sgp4gravconst<whichconst> gc;
+		return satrec.radiusearthkm == gc::radiusearthkm && satrec.xke == gc::xke &&
+			satrec.j2 == gc::j2 && satrec.j3oj2 == gc::j3oj2;
+	}
+
+	// propagation shared by the elsetrec and split record entry points. nearrec_t
+	// provides the near earth terms, deeprec_t the deep space ones, which are only
+	// read when the method is 'd'. config_t gives the gravity constants, opsmode and
+	// method. the results and the resonance integrator state go to state_t, satrec
+	// and deeprec are never written
+	template <class config_t, class nearrec_t, class deeprec_t, class state_t>
+	static bool sgp4core
 		(
-		elsetrec& satrec, double tsince,
-		double r[3], double v[3]
+		const nearrec_t& satrec, const deeprec_t* deeprec, state_t& state, double tsince,
+		double r[3], double v[3], const sgp4_lunarsolar* ls = nullptr
 		)
 	{
 		double am, axnl, aynl, betal, cosim, cnod,
@@ -1763,6 +1923,10 @@ namespace SGP4Funcs
 			twopi, x2o3, vkmpersec, delmtemp;
 		int ktr;
 
+		// the long and short period coefficients are recomputed for deep space satellites
+		double aycof = satrec.aycof, xlcof = satrec.xlcof, con41 = satrec.con41,
+			x1mth2 = satrec.x1mth2, x7thm1 = satrec.x7thm1;
+
 		/* ------------------ set mathematical constants --------------- */
 		// sgp4fix divisor for divide by zero check on inclination
 		// the old check used 1.0 + cos(pi-1.0e-9), but then compared it to
@@ -1772,27 +1936,27 @@ namespace SGP4Funcs
 		x2o3 = 2.0 / 3.0;
 		// sgp4fix identify constants and allow alternate values
 		// getgravconst( whichconst, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2 );
-		vkmpersec = satrec.radiusearthkm * satrec.xke / 60.0;
+		vkmpersec = config_t::radiusearthkm(satrec) * config_t::xke(satrec) / 60.0;
 
 		/* --------------------- clear sgp4 error flag ----------------- */
-		satrec.t = tsince;
-		satrec.error = 0;
+		state.t = tsince;
+		state.error = 0;
 
 		/* ------- update for secular gravity and atmospheric drag ----- */
-		xmdf = satrec.mo + satrec.mdot * satrec.t;
-		argpdf = satrec.argpo + satrec.argpdot * satrec.t;
-		nodedf = satrec.nodeo + satrec.nodedot * satrec.t;
+		xmdf = satrec.mo + satrec.mdot * state.t;
+		argpdf = satrec.argpo + satrec.argpdot * state.t;
+		nodedf = satrec.nodeo + satrec.nodedot * state.t;
 		argpm = argpdf;
 		mm = xmdf;
-		t2 = satrec.t * satrec.t;
+		t2 = state.t * state.t;
 		nodem = nodedf + satrec.nodecf * t2;
-		tempa = 1.0 - satrec.cc1 * satrec.t;
-		tempe = satrec.bstar * satrec.cc4 * satrec.t;
+		tempa = 1.0 - satrec.cc1 * state.t;
+		tempe = satrec.bstar * satrec.cc4 * state.t;
 		templ = satrec.t2cof * t2;
 
 		if (satrec.isimp != 1)
 		{
-			delomg = satrec.omgcof * satrec.t;
+			delomg = satrec.omgcof * state.t;
 			// sgp4fix use mutliply for speed instead of pow
 			delmtemp = 1.0 + satrec.eta * cos(xmdf);
 			delm = satrec.xmcof *
@@ -1801,48 +1965,61 @@ namespace SGP4Funcs
 			temp = delomg + delm;
 			mm = xmdf + temp;
 			argpm = argpdf - temp;
-			t3 = t2 * satrec.t;
-			t4 = t3 * satrec.t;
+			t3 = t2 * state.t;
+			t4 = t3 * state.t;
 			tempa = tempa - satrec.d2 * t2 - satrec.d3 * t3 -
 				satrec.d4 * t4;
 			tempe = tempe + satrec.bstar * satrec.cc5 * (sin(mm) -
 				satrec.sinmao);
 			templ = templ + satrec.t3cof * t3 + t4 * (satrec.t4cof +
-				satrec.t * satrec.t5cof);
+				state.t * satrec.t5cof);
 		}
 
 		nm = satrec.no_unkozai;
 		em = satrec.ecco;
 		inclm = satrec.inclo;
-		if (satrec.method == 'd')
+		if (config_t::method(satrec) == 'd')
 		{
-			tc = satrec.t;
+			// checkpoints computed for another satellite are dropped
+			sgp4_dscheckpoints* checkpoints = dscheckpointsof(state);
+			unsigned long long serial = dsserialof(*deeprec);
+			if (checkpoints && (checkpoints->owner != serial || serial == 0))
+			{
+				checkpoints->owner = serial;
+				checkpoints->xlipos.clear();
+				checkpoints->xnipos.clear();
+				checkpoints->xlineg.clear();
+				checkpoints->xnineg.clear();
+				state.atime = 0.0;
+			}
+
+			tc = state.t;
 			dspace
 				(
-				satrec.irez,
-				satrec.d2201, satrec.d2211, satrec.d3210,
-				satrec.d3222, satrec.d4410, satrec.d4422,
-				satrec.d5220, satrec.d5232, satrec.d5421,
-				satrec.d5433, satrec.dedt, satrec.del1,
-				satrec.del2, satrec.del3, satrec.didt,
-				satrec.dmdt, satrec.dnodt, satrec.domdt,
-				satrec.argpo, satrec.argpdot, satrec.t, tc,
-				satrec.gsto, satrec.xfact, satrec.xlamo,
-				satrec.no_unkozai, satrec.atime,
-				em, argpm, inclm, satrec.xli, mm, satrec.xni,
-				nodem, dndt, nm
+				deeprec->irez,
+				deeprec->d2201, deeprec->d2211, deeprec->d3210,
+				deeprec->d3222, deeprec->d4410, deeprec->d4422,
+				deeprec->d5220, deeprec->d5232, deeprec->d5421,
+				deeprec->d5433, deeprec->dedt, deeprec->del1,
+				deeprec->del2, deeprec->del3, deeprec->didt,
+				deeprec->dmdt, deeprec->dnodt, deeprec->domdt,
+				satrec.argpo, satrec.argpdot, state.t, tc,
+				deeprec->gsto, deeprec->xfact, deeprec->xlamo,
+				satrec.no_unkozai, state.atime,
+				em, argpm, inclm, state.xli, mm, state.xni,
+				nodem, dndt, nm, checkpoints
 				);
 		} // if method = d
 
 		if (nm <= 0.0)
 		{
 			//         printf("# error nm %f\n", nm);
-			satrec.error = 2;
+			state.error = 2;
 			// sgp4fix add return
 			return false;
 		}
-		am = pow((satrec.xke / nm), x2o3) * tempa * tempa;
-		nm = satrec.xke / pow(am, 1.5);
+		am = pow((config_t::xke(satrec) / nm), x2o3) * tempa * tempa;
+		nm = config_t::xke(satrec) / pow(am, 1.5);
 		em = em - tempe;
 
 		// fix tolerance for error recognition
@@ -1850,7 +2027,7 @@ namespace SGP4Funcs
 		if ((em >= 1.0) || (em < -0.001)/* || (am < 0.95)*/)
 		{
 			//         printf("# error em %f\n", em);
-			satrec.error = 1;
+			state.error = 1;
 			// sgp4fix to return if there is an error in eccentricity
 			return false;
 		}
@@ -1868,13 +2045,13 @@ namespace SGP4Funcs
 		mm = fmod(xlm - argpm - nodem, twopi);
 
 		// sgp4fix recover singly averaged mean elements
-		satrec.am = am;
-		satrec.em = em;
-		satrec.im = inclm;
-		satrec.Om = nodem;
-		satrec.om = argpm;
-		satrec.mm = mm;
-		satrec.nm = nm;
+		state.am = am;
+		state.em = em;
+		state.im = inclm;
+		state.Om = nodem;
+		state.om = argpm;
+		state.mm = mm;
+		state.nm = nm;
 
 		/* ----------------- compute extra mean quantities ------------- */
 		sinim = sin(inclm);
@@ -1888,22 +2065,22 @@ namespace SGP4Funcs
 		mp = mm;
 		sinip = sinim;
 		cosip = cosim;
-		if (satrec.method == 'd')
+		if (config_t::method(satrec) == 'd')
 		{
 			dpper
 				(
-				satrec.e3, satrec.ee2, satrec.peo,
-				satrec.pgho, satrec.pho, satrec.pinco,
-				satrec.plo, satrec.se2, satrec.se3,
-				satrec.sgh2, satrec.sgh3, satrec.sgh4,
-				satrec.sh2, satrec.sh3, satrec.si2,
-				satrec.si3, satrec.sl2, satrec.sl3,
-				satrec.sl4, satrec.t, satrec.xgh2,
-				satrec.xgh3, satrec.xgh4, satrec.xh2,
-				satrec.xh3, satrec.xi2, satrec.xi3,
-				satrec.xl2, satrec.xl3, satrec.xl4,
-				satrec.zmol, satrec.zmos, satrec.inclo,
-				'n', ep, xincp, nodep, argpp, mp, satrec.operationmode
+				deeprec->e3, deeprec->ee2, deeprec->peo,
+				deeprec->pgho, deeprec->pho, deeprec->pinco,
+				deeprec->plo, deeprec->se2, deeprec->se3,
+				deeprec->sgh2, deeprec->sgh3, deeprec->sgh4,
+				deeprec->sh2, deeprec->sh3, deeprec->si2,
+				deeprec->si3, deeprec->sl2, deeprec->sl3,
+				deeprec->sl4, state.t, deeprec->xgh2,
+				deeprec->xgh3, deeprec->xgh4, deeprec->xh2,
+				deeprec->xh3, deeprec->xi2, deeprec->xi3,
+				deeprec->xl2, deeprec->xl3, deeprec->xl4,
+				deeprec->zmol, deeprec->zmos, satrec.inclo,
+				'n', ep, xincp, nodep, argpp, mp, config_t::opsmode(satrec), ls
 				);
 			if (xincp < 0.0)
 			{
@@ -1914,28 +2091,28 @@ namespace SGP4Funcs
 			if ((ep < 0.0) || (ep > 1.0))
 			{
 				//            printf("# error ep %f\n", ep);
-				satrec.error = 3;
+				state.error = 3;
 				// sgp4fix add return
 				return false;
 			}
 		} // if method = d
 
 		/* -------------------- long period periodics ------------------ */
-		if (satrec.method == 'd')
+		if (config_t::method(satrec) == 'd')
 		{
 			sinip = sin(xincp);
 			cosip = cos(xincp);
-			satrec.aycof = -0.5*satrec.j3oj2*sinip;
+			aycof = -0.5*config_t::j3oj2(satrec)*sinip;
 			// sgp4fix for divide by zero for xincp = 180 deg
 			if (fabs(cosip + 1.0) > 1.5e-12)
-				satrec.xlcof = -0.25 * satrec.j3oj2 * sinip * (3.0 + 5.0 * cosip) / (1.0 + cosip);
+				xlcof = -0.25 * config_t::j3oj2(satrec) * sinip * (3.0 + 5.0 * cosip) / (1.0 + cosip);
 			else
-				satrec.xlcof = -0.25 * satrec.j3oj2 * sinip * (3.0 + 5.0 * cosip) / temp4;
+				xlcof = -0.25 * config_t::j3oj2(satrec) * sinip * (3.0 + 5.0 * cosip) / temp4;
 		}
 		axnl = ep * cos(argpp);
 		temp = 1.0 / (am * (1.0 - ep * ep));
-		aynl = ep* sin(argpp) + temp * satrec.aycof;
-		xl = mp + argpp + nodep + temp * satrec.xlcof * axnl;
+		aynl = ep* sin(argpp) + temp * aycof;
+		xl = mp + argpp + nodep + temp * xlcof * axnl;
 
 		/* --------------------- solve kepler's equation --------------- */
 		u = fmod(xl - nodep, twopi);
@@ -1964,7 +2141,7 @@ namespace SGP4Funcs
 		if (pl < 0.0)
 		{
 			//         printf("# error pl %f\n", pl);
-			satrec.error = 4;
+			state.error = 4;
 			// sgp4fix add return
 			return false;
 		}
@@ -1981,25 +2158,25 @@ namespace SGP4Funcs
 			sin2u = (cosu + cosu) * sinu;
 			cos2u = 1.0 - 2.0 * sinu * sinu;
 			temp = 1.0 / pl;
-			temp1 = 0.5 * satrec.j2 * temp;
+			temp1 = 0.5 * config_t::j2(satrec) * temp;
 			temp2 = temp1 * temp;
 
 			/* -------------- update for short period periodics ------------ */
-			if (satrec.method == 'd')
+			if (config_t::method(satrec) == 'd')
 			{
 				cosisq = cosip * cosip;
-				satrec.con41 = 3.0*cosisq - 1.0;
-				satrec.x1mth2 = 1.0 - cosisq;
-				satrec.x7thm1 = 7.0*cosisq - 1.0;
+				con41 = 3.0*cosisq - 1.0;
+				x1mth2 = 1.0 - cosisq;
+				x7thm1 = 7.0*cosisq - 1.0;
 			}
-			mrt = rl * (1.0 - 1.5 * temp2 * betal * satrec.con41) +
-				0.5 * temp1 * satrec.x1mth2 * cos2u;
-			su = su - 0.25 * temp2 * satrec.x7thm1 * sin2u;
+			mrt = rl * (1.0 - 1.5 * temp2 * betal * con41) +
+				0.5 * temp1 * x1mth2 * cos2u;
+			su = su - 0.25 * temp2 * x7thm1 * sin2u;
 			xnode = nodep + 1.5 * temp2 * cosip * sin2u;
 			xinc = xincp + 1.5 * temp2 * cosip * sinip * cos2u;
-			mvt = rdotl - nm * temp1 * satrec.x1mth2 * sin2u / satrec.xke;
-			rvdot = rvdotl + nm * temp1 * (satrec.x1mth2 * cos2u +
-				1.5 * satrec.con41) / satrec.xke;
+			mvt = rdotl - nm * temp1 * x1mth2 * sin2u / config_t::xke(satrec);
+			rvdot = rvdotl + nm * temp1 * (x1mth2 * cos2u +
+				1.5 * con41) / config_t::xke(satrec);
 
 			/* --------------------- orientation vectors ------------------- */
 			sinsu = sin(su);
@@ -2018,9 +2195,9 @@ namespace SGP4Funcs
 			vz = sini * cossu;
 
 			/* --------- position and velocity (in km and km/sec) ---------- */
-			r[0] = (mrt * ux)* satrec.radiusearthkm;
-			r[1] = (mrt * uy)* satrec.radiusearthkm;
-			r[2] = (mrt * uz)* satrec.radiusearthkm;
+			r[0] = (mrt * ux)* config_t::radiusearthkm(satrec);
+			r[1] = (mrt * uy)* config_t::radiusearthkm(satrec);
+			r[2] = (mrt * uz)* config_t::radiusearthkm(satrec);
 			v[0] = (mvt * ux + rvdot * vx) * vkmpersec;
 			v[1] = (mvt * uy + rvdot * vy) * vkmpersec;
 			v[2] = (mvt * uz + rvdot * vz) * vkmpersec;
@@ -2030,14 +2207,317 @@ namespace SGP4Funcs
 		if (mrt < 1.0)
 		{
 			//         printf("# decay condition %11.6f \n",mrt);
-			satrec.error = 6;
+			state.error = 6;
 			return false;
 		}
 
 		//#include "debug7.cpp"
 		return true;
+	}  // sgp4core
+
+	// the opsmode is only read by the deep space periodics, near earth satellites
+	// share one specialization
+	template <gravconsttype whichconst, class nearrec_t, class deeprec_t, class state_t>
+	static bool sgp4fixedcore
+		(
+		const nearrec_t& satrec, const deeprec_t* deeprec, state_t& state, double tsince,
+		double r[3], double v[3], const sgp4_lunarsolar* ls
+		)
+	{
+		if (satrec.method != 'd')
+			return sgp4core<sgp4fixedconfig<whichconst, 'a', 'n'>>(satrec, deeprec, state, tsince, r, v);
+		if (satrec.operationmode == 'a')
+			return sgp4core<sgp4fixedconfig<whichconst, 'a', 'd'>>(satrec, deeprec, state, tsince, r, v, ls);
+		return sgp4core<sgp4fixedconfig<whichconst, 'i', 'd'>>(satrec, deeprec, state, tsince, r, v, ls);
+	}
+
+	// picks the specialization matching the gravity constants of the record, records
+	// with other constants go through the runtime configuration
+	template <class nearrec_t, class deeprec_t, class state_t>
+	static bool sgp4dispatch
+		(
+		const nearrec_t& satrec, const deeprec_t* deeprec, state_t& state, double tsince,
+		double r[3], double v[3], const sgp4_lunarsolar* ls = nullptr
+		)
+	{
+		if (hasgravconst<wgs72>(satrec))
+			return sgp4fixedcore<wgs72>(satrec, deeprec, state, tsince, r, v, ls);
+		if (hasgravconst<wgs84>(satrec))
+			return sgp4fixedcore<wgs84>(satrec, deeprec, state, tsince, r, v, ls);
+		if (hasgravconst<wgs72old>(satrec))
+			return sgp4fixedcore<wgs72old>(satrec, deeprec, state, tsince, r, v, ls);
+		return sgp4core<sgp4runtimeconfig>(satrec, deeprec, state, tsince, r, v, ls);
+	}
+
+	bool sgp4
+		(
+		elsetrec& satrec, double tsince,
+		double r[3], double v[3]
+		)
+	{
+		return sgp4dispatch(satrec, &satrec, satrec, tsince, r, v);
+	}  // sgp4
+
+	bool sgp4
+		(
+		const elsetrec_near& nearrec, const elsetrec_deep* deeprec, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		)
+	{
+		return sgp4dispatch(nearrec, deeprec, state, tsince, r, v);
+	}  // sgp4
+
+	bool sgp4
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		)
+	{
+		return sgp4dispatch(model.near, model.deep.get(), state, tsince, r, v);
+	}  // sgp4
+
+	bool sgp4
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince, const sgp4_lunarsolar& ls,
+		double r[3], double v[3]
+		)
+	{
+		return sgp4dispatch(model.near, model.deep.get(), state, tsince, r, v, &ls);
 	}  // sgp4
 
+	/* -----------------------------------------------------------------------------
+	*
+	*                           procedure lunarsolarterms
+	*
+	*  this procedure computes the sun and moon terms of the deep space long period
+	*    periodics at a date. dscom gives the mean anomalies at epoch and dpper
+	*    extrapolates them with the rates zns and znl, here the dscom expressions
+	*    are evaluated at the date itself so that the terms are the same for every
+	*    satellite. the rates differ by 8e-11 rad/min for the sun, so the anomaly of
+	*    a satellite drifts from the one of the date by up to 5e-5 rad one year
+	*    away from epoch : dpper adds the first order correction with the
+	*    derivatives below, the second order term stays under 1e-9.
+	*
+	*  inputs        :
+	*    jd          - julian date (days from 4713 bc)
+	*
+	*  outputs       :
+	*    ls          - sun (s) and moon (l) zm, sinzf, f2, f3 of dpper and the
+	*                  derivatives of sinzf, f2, f3 with respect to zm
+	*
+	*  coupling      :
+	*    none.
+	*
+	*  references    :
+	*    hoots, roehrich, norad spacetrack report #3 1980
+	  ---------------------------------------------------------------------------- */
+
+	void lunarsolarterms
+		(
+		double jd, sgp4_lunarsolar& ls
+		)
+	{
+		const double twopi = 2.0 * pi;
+		const double zes = 0.01675;
+		const double zel = 0.05490;
+		double day, gam, zf, dzf, coszf;
+
+		// days from 0 jan 1900 12h, the day of dscom
+		day = jd - 2415020.0;
+		gam = 5.8351514 + 0.0019443680 * day;
+
+		ls.jd = jd;
+
+		ls.zms = fmod(6.2565837 + 0.017201977 * day, twopi);
+		zf = ls.zms + 2.0 * zes * sin(ls.zms);
+		dzf = 1.0 + 2.0 * zes * cos(ls.zms);
+		coszf = cos(zf);
+		ls.sinzfs = sin(zf);
+		ls.f2s = 0.5 * ls.sinzfs * ls.sinzfs - 0.25;
+		ls.f3s = -0.5 * ls.sinzfs * coszf;
+		ls.dsinzfs = coszf * dzf;
+		ls.df2s = ls.sinzfs * ls.dsinzfs;
+		ls.df3s = -0.5 * dzf * (coszf * coszf - ls.sinzfs * ls.sinzfs);
+
+		ls.zml = fmod(4.7199672 + 0.22997150 * day - gam, twopi);
+		zf = ls.zml + 2.0 * zel * sin(ls.zml);
+		dzf = 1.0 + 2.0 * zel * cos(ls.zml);
+		coszf = cos(zf);
+		ls.sinzfl = sin(zf);
+		ls.f2l = 0.5 * ls.sinzfl * ls.sinzfl - 0.25;
+		ls.f3l = -0.5 * ls.sinzfl * coszf;
+		ls.dsinzfl = coszf * dzf;
+		ls.df2l = ls.sinzfl * ls.dsinzfl;
+		ls.df3l = -0.5 * dzf * (coszf * coszf - ls.sinzfl * ls.sinzfl);
+	}  // lunarsolarterms
+
+	bool sgp4runtime
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		)
+	{
+		return sgp4core<sgp4runtimeconfig>(model.near, model.deep.get(), state, tsince, r, v);
+	}  // sgp4runtime
+
+	template <gravconsttype whichconst, char opsmode, char method>
+	bool sgp4fixed
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		)
+	{
+		static_assert(method == 'n' || method == 'd', "method is 'n' or 'd'");
+		return sgp4core<sgp4fixedconfig<whichconst, opsmode, method>>(model.near, model.deep.get(), state, tsince, r, v);
+	}  // sgp4fixed
+
+	template bool sgp4fixed<wgs72old, 'a', 'n'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs72old, 'a', 'd'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs72old, 'i', 'n'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs72old, 'i', 'd'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs72, 'a', 'n'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs72, 'a', 'd'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs72, 'i', 'n'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs72, 'i', 'd'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs84, 'a', 'n'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs84, 'a', 'd'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs84, 'i', 'n'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+	template bool sgp4fixed<wgs84, 'i', 'd'>(const sgp4_model&, sgp4_state&, double, double[3], double[3]);
+
+	/* -----------------------------------------------------------------------------
+	*
+	*                   procedures splitelsetrec, mergeelsetrec
+	*
+	*  these procedures move the fields of an initialized elsetrec to and from the
+	*    compact propagation records. elsetrec_near gets everything sgp4 reads for
+	*    a near earth satellite, elsetrec_deep the deep space terms, elsetrec_meta
+	*    the tle and catalogue information. the propagation results (t, error, the
+	*    resonance integrator and the singly averaged mean elements) belong to
+	*    sgp4_state, they are not carried and are cleared by mergeelsetrec.
+	*
+	*  inputs        :
+	*    satrec      - initialized elsetrec (splitelsetrec)
+	*    nearrec, deeprec, metarec - split records (mergeelsetrec), deeprec and
+	*                  metarec may be null
+	*
+	*  outputs       :
+	*    nearrec, deeprec, metarec - split records (splitelsetrec), deeprec and
+	*                  metarec may be null
+	*    satrec      - rebuilt elsetrec (mergeelsetrec)
+	  ---------------------------------------------------------------------------- */
+
+	// the field lists are written once and used in both directions
+	template <class dst_t, class src_t>
+	static void copynearfields(dst_t& d, const src_t& s)
+	{
+		d.mo = s.mo;           d.mdot = s.mdot;       d.argpo = s.argpo;
+		d.argpdot = s.argpdot; d.nodeo = s.nodeo;     d.nodedot = s.nodedot;
+		d.nodecf = s.nodecf;   d.bstar = s.bstar;     d.cc1 = s.cc1;
+		d.cc4 = s.cc4;         d.cc5 = s.cc5;         d.t2cof = s.t2cof;
+		d.t3cof = s.t3cof;     d.t4cof = s.t4cof;     d.t5cof = s.t5cof;
+		d.d2 = s.d2;           d.d3 = s.d3;           d.d4 = s.d4;
+		d.omgcof = s.omgcof;   d.xmcof = s.xmcof;     d.eta = s.eta;
+		d.delmo = s.delmo;     d.sinmao = s.sinmao;
+		d.no_unkozai = s.no_unkozai; d.ecco = s.ecco; d.inclo = s.inclo;
+		d.aycof = s.aycof;     d.xlcof = s.xlcof;     d.con41 = s.con41;
+		d.x1mth2 = s.x1mth2;   d.x7thm1 = s.x7thm1;
+		d.xke = s.xke;         d.j2 = s.j2;           d.j3oj2 = s.j3oj2;
+		d.radiusearthkm = s.radiusearthkm;
+		d.isimp = s.isimp;
+		d.method = s.method;   d.operationmode = s.operationmode;
+	}
+
+	template <class dst_t, class src_t>
+	static void copydeepfields(dst_t& d, const src_t& s)
+	{
+		d.irez = s.irez;
+		d.d2201 = s.d2201; d.d2211 = s.d2211; d.d3210 = s.d3210; d.d3222 = s.d3222;
+		d.d4410 = s.d4410; d.d4422 = s.d4422; d.d5220 = s.d5220; d.d5232 = s.d5232;
+		d.d5421 = s.d5421; d.d5433 = s.d5433; d.dedt = s.dedt;   d.del1 = s.del1;
+		d.del2 = s.del2;   d.del3 = s.del3;   d.didt = s.didt;   d.dmdt = s.dmdt;
+		d.dnodt = s.dnodt; d.domdt = s.domdt; d.e3 = s.e3;       d.ee2 = s.ee2;
+		d.peo = s.peo;     d.pgho = s.pgho;   d.pho = s.pho;     d.pinco = s.pinco;
+		d.plo = s.plo;     d.se2 = s.se2;     d.se3 = s.se3;     d.sgh2 = s.sgh2;
+		d.sgh3 = s.sgh3;   d.sgh4 = s.sgh4;   d.sh2 = s.sh2;     d.sh3 = s.sh3;
+		d.si2 = s.si2;     d.si3 = s.si3;     d.sl2 = s.sl2;     d.sl3 = s.sl3;
+		d.sl4 = s.sl4;     d.gsto = s.gsto;   d.xfact = s.xfact; d.xgh2 = s.xgh2;
+		d.xgh3 = s.xgh3;   d.xgh4 = s.xgh4;   d.xh2 = s.xh2;     d.xh3 = s.xh3;
+		d.xi2 = s.xi2;     d.xi3 = s.xi3;     d.xl2 = s.xl2;     d.xl3 = s.xl3;
+		d.xl4 = s.xl4;     d.xlamo = s.xlamo; d.zmol = s.zmol;   d.zmos = s.zmos;
+	}
+
+	template <class dst_t, class src_t>
+	static void copymetafields(dst_t& d, const src_t& s)
+	{
+		memcpy(d.satnum, s.satnum, sizeof(d.satnum));
+		d.epochyr = s.epochyr; d.epochtynumrev = s.epochtynumrev;
+		d.init = s.init;
+		d.a = s.a;             d.altp = s.altp;       d.alta = s.alta;
+		d.epochdays = s.epochdays;
+		d.jdsatepoch = s.jdsatepoch; d.jdsatepochF = s.jdsatepochF;
+		d.nddot = s.nddot;     d.ndot = s.ndot;       d.rcse = s.rcse;
+		d.no_kozai = s.no_kozai;
+		d.classification = s.classification;
+		memcpy(d.intldesg, s.intldesg, sizeof(d.intldesg));
+		d.ephtype = s.ephtype;
+		d.elnum = s.elnum;     d.revnum = s.revnum;
+		d.tumin = s.tumin;     d.mus = s.mus;         d.j3 = s.j3;   d.j4 = s.j4;
+		d.dia_mm = s.dia_mm;   d.period_sec = s.period_sec;
+		d.active = s.active;   d.not_orbital = s.not_orbital;
+		d.rcs_m2 = s.rcs_m2;
+	}
+
+	void splitelsetrec
+		(
+		const elsetrec& satrec,
+		elsetrec_near& nearrec, elsetrec_deep* deeprec, elsetrec_meta* metarec
+		)
+	{
+		copynearfields(nearrec, satrec);
+		if (deeprec)
+		{
+			copydeepfields(*deeprec, satrec);
+			deeprec->serial = newdsserial();
+		}
+		if (metarec)
+			copymetafields(*metarec, satrec);
+	}  // splitelsetrec
+
+	void mergeelsetrec
+		(
+		const elsetrec_near& nearrec, const elsetrec_deep* deeprec, const elsetrec_meta* metarec,
+		elsetrec& satrec
+		)
+	{
+		memset(&satrec, 0, sizeof(satrec));
+		copynearfields(satrec, nearrec);
+		if (deeprec)
+			copydeepfields(satrec, *deeprec);
+		if (metarec)
+			copymetafields(satrec, *metarec);
+		else
+			satrec.init = 'n';
+	}  // mergeelsetrec
+
+	void makesgp4model
+		(
+		const elsetrec& satrec, sgp4_model& model
+		)
+	{
+		copynearfields(model.near, satrec);
+		copymetafields(model.meta, satrec);
+
+		if (satrec.method == 'd')
+		{
+			auto deeprec = std::make_shared<elsetrec_deep>();
+			copydeepfields(*deeprec, satrec);
+			deeprec->serial = newdsserial();
+			model.deep = deeprec;
+		}
+		else
+			model.deep.reset();
+	}  // makesgp4model
+
 
 
 
@@ -54,6 +54,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #define SGP4Version  "SGP4 Version 2020-07-13"
 
@@ -112,6 +114,116 @@ typedef struct elsetrec
 
 } elsetrec;
 
+// ------------------------ split propagation records ---------------------------
+// elsetrec_near holds only the terms sgp4 reads for a near earth satellite, hot
+// terms first, so that one propagation touches 5 cache lines instead of 8 or 9
+// scattered over an elsetrec. deep space satellites (method 'd') also need an
+// elsetrec_deep block, the tle metadata and catalogue fields go to elsetrec_meta.
+typedef struct alignas(64) elsetrec_near
+{
+  /* secular gravity and atmospheric drag */
+  double mo     , mdot   , argpo  , argpdot  , nodeo  , nodedot , nodecf,
+         bstar  , cc1    , cc4    , cc5      , t2cof  , t3cof   , t4cof , t5cof ,
+         d2     , d3     , d4     , omgcof   , xmcof  , eta     , delmo , sinmao;
+
+  /* mean elements */
+  double no_unkozai, ecco, inclo;
+
+  /* long and short period periodics, recomputed at each call for method 'd' */
+  double aycof  , xlcof  , con41  , x1mth2   , x7thm1;
+
+  double xke, j2, j3oj2, radiusearthkm;
+
+  int    isimp;
+  char   method, operationmode;
+} elsetrec_near;
+
+typedef struct elsetrec_deep
+{
+  int    irez;
+  double d2201  , d2211  , d3210  , d3222    , d4410  , d4422   , d5220 , d5232 ,
+         d5421  , d5433  , dedt   , del1     , del2   , del3    , didt  , dmdt  ,
+         dnodt  , domdt  , e3     , ee2      , peo    , pgho    , pho   , pinco ,
+         plo    , se2    , se3    , sgh2     , sgh3   , sgh4    , sh2   , sh3   ,
+         si2    , si3    , sl2    , sl3      , sl4    , gsto    , xfact , xgh2  ,
+         xgh3   , xgh4   , xh2    , xh3      , xi2    , xi3     , xl2   , xl3   ,
+         xl4    , xlamo  , zmol   , zmos;
+
+  // set by splitelsetrec and makesgp4model, unique to each block they fill. keys the
+  // integrator checkpoints of sgp4_state, a block freed and another one allocated at
+  // the same address still get different serials. 0 : never reuse the checkpoints
+  unsigned long long serial;
+} elsetrec_deep;
+
+typedef struct elsetrec_meta
+{
+  char   satnum[6];
+  int    epochyr, epochtynumrev;
+  char   init;
+
+  double a, altp, alta, epochdays, jdsatepoch, jdsatepochF, nddot, ndot,
+         rcse, no_kozai;
+  char   classification, intldesg[11];
+  int    ephtype;
+  long   elnum    , revnum;
+  double tumin, mus, j3, j4;
+
+  long   dia_mm;
+  double period_sec;
+  unsigned char active, not_orbital;
+  double rcs_m2;
+} elsetrec_meta;
+
+// initialized satellite. sgp4 never writes into a model, so one model can be shared
+// by several threads, each of them propagating it with its own sgp4_state
+typedef struct sgp4_model
+{
+  elsetrec_near near;
+  std::shared_ptr<const elsetrec_deep> deep;  // null for near earth satellites
+  elsetrec_meta meta;
+} sgp4_model;
+
+// deep space resonance integrator values after each 720 min step, step k on one
+// side of epoch is stored at index k - 1. sgp4 fills them as the integrator moves
+// and resumes any later query from the last step before it, so going back in time
+// no longer restarts the integration from epoch
+typedef struct sgp4_dscheckpoints
+{
+  unsigned long long owner;             // serial of the deep block the steps were computed for
+  std::vector<double> xlipos, xnipos;   // t > 0
+  std::vector<double> xlineg, xnineg;   // t < 0
+} sgp4_dscheckpoints;
+
+// per caller scratch and results of sgp4. a value-initialized state (sgp4_state{}) is
+// valid for any model, the deep space integrator restarts from epoch when atime is 0.
+// the checkpoints hold vectors : the state cannot be cleared with memset
+typedef struct sgp4_state
+{
+  double t;
+  int    error;
+
+  /* resonance integrator */
+  double atime  , xli    , xni;
+
+  /* singly averaged mean elements */
+  double am     , em     , im     , Om       , om     , mm      , nm;
+
+  sgp4_dscheckpoints checkpoints;
+} sgp4_state;
+
+// sun and moon terms of the deep space periodics at one date. they only depend on
+// the time, lunarsolarterms computes them once for all the deep space satellites
+// propagated to that date. each satellite extrapolates the anomalies from its own
+// epoch with slightly different rates, the derivatives carry the terms over to it
+typedef struct sgp4_lunarsolar
+{
+  double jd;
+  /* sun */
+  double zms    , sinzfs , f2s    , f3s    , dsinzfs, df2s   , df3s;
+  /* moon */
+  double zml    , sinzfl , f2l    , f3l    , dsinzfl, df2l   , df3l;
+} sgp4_lunarsolar;
+
 
 namespace SGP4Funcs 
 {
@@ -134,6 +246,76 @@ namespace SGP4Funcs
 		double r[3], double v[3]
 		);
 
+	// same propagation on the split records, deeprec is only read for method 'd'
+	// and may be null for near earth satellites. the records are not modified,
+	// t, error and the integrator state go to the caller's state
+	bool sgp4
+		(
+		const elsetrec_near& nearrec, const elsetrec_deep* deeprec, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		);
+
+	bool sgp4
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		);
+
+	// same with the sun and moon terms of ls, tsince must be the date of ls. the
+	// terms are carried to the satellite at first order, positions differ from the
+	// plain sgp4 by less than 1 mm
+	// within a year of epoch
+	bool sgp4
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince, const sgp4_lunarsolar& ls,
+		double r[3], double v[3]
+		);
+
+	void lunarsolarterms
+		(
+		double jd, sgp4_lunarsolar& ls
+		);
+
+	// the sgp4 entry points above dispatch each call to a propagator compiled for
+	// the gravity constants, opsmode and method of the record. sgp4fixed calls one
+	// of them directly, the model must have been initialized with whichconst and
+	// opsmode and have this method. it is instantiated for the three gravity
+	// models, opsmodes 'a' and 'i' and methods 'n' and 'd'
+	template <gravconsttype whichconst, char opsmode, char method>
+	bool sgp4fixed
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		);
+
+	// reads the gravity constants, opsmode and method from the model at each call,
+	// the path taken by the records initialized with other constants
+	bool sgp4runtime
+		(
+		const sgp4_model& model, sgp4_state& state, double tsince,
+		double r[3], double v[3]
+		);
+
+	// conversions between an initialized elsetrec and the split records, the
+	// deep and meta pointers may be null when that part is not wanted
+	void splitelsetrec
+		(
+		const elsetrec& satrec,
+		elsetrec_near& nearrec, elsetrec_deep* deeprec, elsetrec_meta* metarec
+		);
+
+	void mergeelsetrec
+		(
+		const elsetrec_near& nearrec, const elsetrec_deep* deeprec, const elsetrec_meta* metarec,
+		elsetrec& satrec
+		);
+
+	// model of an initialized elsetrec, the deep block is only allocated for method 'd'
+	void makesgp4model
+		(
+		const elsetrec& satrec, sgp4_model& model
+		);
+
 	void getgravconst
 		(
 		gravconsttype whichconst,
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+// Queue written by several threads and read by one, without lock.
+// push() links its node on top of a stack with a compare and swap, it never waits
+// for the reader. The reader takes the whole stack at once and puts it back in the
+// order of the pushes.
+template<typename T>
+class mpsc_queue_t {
+public:
+	mpsc_queue_t() = default;
+
+	~mpsc_queue_t() {
+		_free(head_.exchange(nullptr));
+	}
+
+	mpsc_queue_t(const mpsc_queue_t&) = delete;
+	mpsc_queue_t& operator=(const mpsc_queue_t&) = delete;
+
+	// any thread
+	void push(T value) {
+		node_t* node = new node_t{ std::move(value), head_.load(std::memory_order_relaxed) };
+		while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+		}
+	}
+
+	// reader thread only : appends the values pushed so far to out, oldest first.
+	// Returns the number of values taken
+	size_t pop_all(std::vector<T>& out) {
+		node_t* node = head_.exchange(nullptr, std::memory_order_acquire);
+
+		size_t first = out.size();
+		while (node) {
+			out.push_back(std::move(node->value));
+
+			node_t* next = node->next;
+			delete node;
+			node = next;
+		}
+		std::reverse(out.begin() + first, out.end());
+
+		return out.size() - first;
+	}
+
+	bool empty() const {
+		return head_.load(std::memory_order_acquire) == nullptr;
+	}
+
+private:
+	struct node_t {
+		T value;
+		node_t* next;
+	};
+
+	static void _free(node_t* node) {
+		while (node) {
+			node_t* next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+	std::atomic<node_t*> head_{};
+};
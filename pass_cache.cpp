@@ -0,0 +1,148 @@
+#include "pass_cache.h"
+
+#include <fstream>
+#include <type_traits>
+#include <algorithm>
+
+static_assert(std::is_trivially_copyable_v<pass_t>, "pass_t is written as is");
+
+// scanned again before the date an entry is known up to, the scan must not start in its pass
+static const double rescan_margin = 60.0 / 86400.0;
+static const double same_pass = 1.0 / 86400.0;
+
+static const char cache_magic[8] = { 'S', 'A', 'T', 'P', 'A', 'S', 'S', '1' };
+
+template<typename T>
+static void write_raw(std::ofstream& out, const T* data, size_t count) {
+	out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+template<typename T>
+static bool read_raw(std::ifstream& in, T* data, size_t count) {
+	return (bool)in.read(reinterpret_cast<char*>(data), count * sizeof(T));
+}
+
+bool pass_cache_t::load(const std::string& filename) {
+	clear();
+
+	std::ifstream in(filename, std::ios::binary);
+	if (!in)
+		return false;
+
+	char magic[sizeof(cache_magic)];
+	uint64_t count = 0;
+	if (!read_raw(in, magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), cache_magic) || !read_raw(in, &count, 1))
+		return false;
+
+	for (uint64_t e = 0; e < count; e++) {
+		key_t key{};
+		entry_t entry{};
+		uint64_t name_size = 0;
+		uint64_t passes = 0;
+		if (!read_raw(in, &key, 1) || !read_raw(in, &name_size, 1) || name_size > 1024) {
+			clear();
+			return false;
+		}
+
+		entry.name.resize(name_size);
+		if (!read_raw(in, entry.name.data(), name_size) || !read_raw(in, &entry.jd_from, 1) || !read_raw(in, &entry.jd_to, 1)
+			|| !read_raw(in, &entry.jd_known, 1) || !read_raw(in, &passes, 1) || passes > 100000) {
+			clear();
+			return false;
+		}
+
+		entry.passes.resize(passes);
+		if (!read_raw(in, entry.passes.data(), passes)) {
+			clear();
+			return false;
+		}
+
+		entries_.emplace(key, std::move(entry));
+	}
+
+	return true;
+}
+
+bool pass_cache_t::save(const std::string& filename) const {
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out)
+		return false;
+
+	uint64_t count = entries_.size();
+	write_raw(out, cache_magic, sizeof(cache_magic));
+	write_raw(out, &count, 1);
+	for (auto& [key, entry] : entries_) {
+		uint64_t name_size = entry.name.size();
+		uint64_t passes = entry.passes.size();
+		write_raw(out, &key, 1);
+		write_raw(out, &name_size, 1);
+		write_raw(out, entry.name.data(), name_size);
+		write_raw(out, &entry.jd_from, 1);
+		write_raw(out, &entry.jd_to, 1);
+		write_raw(out, &entry.jd_known, 1);
+		write_raw(out, &passes, 1);
+		write_raw(out, entry.passes.data(), passes);
+	}
+
+	dirty_ = !out.good();
+
+	return out.good();
+}
+
+double pass_cache_t::scan_from(const key_t& key, double jd_start, double jd_end) const {
+	auto it = entries_.find(key);
+	if (it == entries_.end() || it->second.jd_from > jd_start)
+		return jd_start;
+
+	const entry_t& entry = it->second;
+	if (entry.jd_to >= jd_end)
+		return jd_end;
+
+	return std::max(jd_start, entry.jd_known - rescan_margin);
+}
+
+void pass_cache_t::passes(const key_t& key, double jd_start, double jd_end, std::vector<pass_t>& out) const {
+	auto it = entries_.find(key);
+	if (it == entries_.end() || it->second.jd_from > jd_start)
+		return;
+
+	for (const pass_t& pass : it->second.passes) {
+		if (pass.jd_start >= jd_start && pass.jd_end <= jd_end)
+			out.push_back(pass);
+	}
+}
+
+void pass_cache_t::store(const key_t& key, const std::string& name, double jd_start, double jd_scan, double jd_end, double jd_known,
+	const std::vector<pass_t>& passes) {
+	auto it = entries_.find(key);
+	if (it != entries_.end() && it->second.jd_from <= jd_start && jd_scan <= it->second.jd_known) {
+		// the scan joins the entry : the passes it found again are already stored
+		entry_t& entry = it->second;
+		for (const pass_t& pass : passes) {
+			if (entry.passes.empty() || pass.jd_start > entry.passes.back().jd_start + same_pass)
+				entry.passes.push_back(pass);
+		}
+		entry.jd_to = std::max(entry.jd_to, jd_end);
+		entry.jd_known = std::max(entry.jd_known, jd_known);
+	}
+	else
+		it = entries_.insert_or_assign(key, entry_t{ name, jd_scan, jd_end, jd_known, passes }).first;
+
+	entry_t& entry = it->second;
+	std::erase_if(entry.passes, [&](const pass_t& pass) {
+		return pass.jd_start < jd_start;
+	});
+	entry.jd_from = std::max(entry.jd_from, jd_start);
+
+	std::erase_if(entries_, [&](const auto& item) {
+		const auto& [k, e] = item;
+		if (k == key)
+			return false;
+
+		bool replaced = e.name == name && k.tle_hash != key.tle_hash && k.lat == key.lat && k.lon == key.lon
+			&& k.alt == key.alt && k.min_elevation == key.min_elevation;
+		return replaced || e.jd_to < jd_start;
+	});
+
+	dirty_ = true;
+}
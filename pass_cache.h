@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+
+#include "pass_predictor.h"
+
+// Passes of the predictions kept between the runs and on disk. An entry holds the
+// passes of one satellite for one set of elements, observer site and elevation
+// threshold : the key changes with any of them. A window moved forward is only
+// scanned past the date the entry is known up to, a new set of elements replaces
+// the entries of the satellite.
+class pass_cache_t {
+public:
+	struct key_t {
+		uint64_t tle_hash;	// tle_hash() of the elements
+		double lat;			// observer (rad, rad, km)
+		double lon;
+		double alt;
+		double min_elevation;	// threshold of can_rise() (rad)
+
+		auto operator<=>(const key_t&) const = default;
+	};
+
+	pass_cache_t() = default;
+
+	// false when the file is missing or not a cache file, the cache is left empty
+	bool load(const std::string& filename);
+
+	bool save(const std::string& filename) const;
+
+	void clear() {
+		entries_.clear();
+		dirty_ = false;
+	}
+
+	// date the scan of satellite key must start from for the window, jd_end when
+	// the cached passes cover it
+	double scan_from(const key_t& key, double jd_start, double jd_end) const;
+
+	// appends the cached passes starting after jd_start and ended before jd_end, none
+	// when the entry starts after jd_start : the scan covers the whole window then
+	void passes(const key_t& key, double jd_start, double jd_end, std::vector<pass_t>& out) const;
+
+	// passes of a scan from jd_scan to jd_end, jd_known : pass_cursor_t::known() at its end.
+	// Extends the entry when the scan started before the date it was known up to,
+	// replaces it otherwise. The passes before jd_start are dropped, and with them
+	// the entries which ended before it and the former elements of the satellite
+	void store(const key_t& key, const std::string& name, double jd_start, double jd_scan, double jd_end, double jd_known,
+		const std::vector<pass_t>& passes);
+
+	size_t size() const {
+		return entries_.size();
+	}
+
+	// changed since the last load or save
+	bool dirty() const {
+		return dirty_;
+	}
+
+private:
+	struct entry_t {
+		std::string name;	// satellite
+		double jd_from;		// the passes ended between jd_from and jd_to are all stored
+		double jd_to;
+		double jd_known;	// pass_cursor_t::known() at jd_to
+		std::vector<pass_t> passes;
+	};
+
+	std::map<key_t, entry_t> entries_;
+	mutable bool dirty_{};
+};
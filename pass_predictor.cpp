@@ -0,0 +1,603 @@
+#include "pass_predictor.h"
+#include "sgp4_batch.h"
+
+#include <algorithm>
+
+void merge_passes(const std::vector<std::span<const pass_record_t>>& runs, std::vector<pass_record_t>& out) {
+	struct head_t {
+		const pass_record_t* it;
+		const pass_record_t* end;
+	};
+
+	// std heaps keep the largest on top : the later pass compares lower
+	auto later = [](const head_t& a, const head_t& b) {
+		if (a.it->pass.jd_start != b.it->pass.jd_start)
+			return a.it->pass.jd_start > b.it->pass.jd_start;
+		return a.it->sat > b.it->sat;
+	};
+
+	size_t total = 0;
+	std::vector<head_t> heap;
+	heap.reserve(runs.size());
+	for (auto& run : runs) {
+		total += run.size();
+		if (!run.empty())
+			heap.push_back(head_t{ run.data(), run.data() + run.size() });
+	}
+	std::make_heap(heap.begin(), heap.end(), later);
+
+	out.clear();
+	out.reserve(total);
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), later);
+		head_t& head = heap.back();
+		out.push_back(*head.it);
+		if (++head.it == head.end)
+			heap.pop_back();
+		else
+			std::push_heap(heap.begin(), heap.end(), later);
+	}
+}
+
+bool can_rise(const sgp4_model& model, const observer_t& observer, double min_elevation) {
+	constexpr double margin = 2.0 * M_PI / 180.0;
+
+	// geocentric distance and latitude of the observer
+	vector_t site = observer.position(sidereal_t{ 0.0, 0.0, 1.0 });
+	double rho = site.mag();
+	double lat = std::atan2(site.z, site.x);
+
+	// the ground track stays between -incl and incl
+	double incl = model.near.inclo;
+	if (incl > M_PI / 2)
+		incl = M_PI - incl;
+
+	double apogee = (1.0 + model.meta.alta) * model.near.radiusearthkm;
+
+	// largest central angle between the observer and the satellite at min_elevation
+	double elev = std::max(min_elevation, 0.0);
+	double c = rho * std::cos(elev) / apogee;
+	if (c >= 1.0)
+		return false;
+
+	double reach = std::acos(c) - elev;
+
+	return std::fabs(lat) - incl <= reach + margin;
+}
+
+namespace {
+
+	// samples per period of the grid of the adaptive scan, 4 h apart at most
+	constexpr double grid_per_rev = 6.0;
+	constexpr double grid_step_max = 4.0 / 24.0;
+
+	// largest error of the crossing guesses of the scan, nearly all within 2 s
+	constexpr double guess_margin = 2.0 / 86400.0;
+
+	bool is_geostationary(const sgp4_model& model) {
+		return (int)((2.0 * M_PI) / model.meta.no_kozai) == 1436;	// 1 sideral day : 23h 56mn 4.0905 s = 1436.068175 mn
+	}
+
+	// the central angle between two vectors is larger than the one of cos_t, from
+	// their dot product and the product of their squared norms : no square root
+	bool beyond(double dot, double norms, double cos_t) {
+		if (cos_t >= 0.0)
+			return dot < 0.0 || sqr(dot) < sqr(cos_t) * norms;
+		return dot < 0.0 && sqr(dot) > sqr(cos_t) * norms;
+	}
+}
+
+bool pass_builder_t::crossing(double jd_prev, double sin_prev, double jd, double sin_elev, double guess) {
+	size_t evaluations = eval_.evaluations();
+
+	// the guess, then a date a little farther on the side of the crossing, bracket it closely
+	double jd_a = jd_prev, sin_a = sin_prev;
+	double jd_b = jd, sin_b = sin_elev;
+	for (int i = 0; i < 2 && guess > jd_a && guess < jd_b; i++) {
+		double f = eval_.sin_elevation(guess);
+		if (eval_.error() != 0 || f == 0.0)
+			break;
+
+		if (f * sin_a < 0.0) {
+			jd_b = guess;
+			sin_b = f;
+			guess -= guess_margin;
+		}
+		else {
+			jd_a = guess;
+			sin_a = f;
+			guess += guess_margin;
+		}
+	}
+
+	crossing_t c = find_crossing(eval_, jd_a, sin_a, jd_b, sin_b);
+	if (stats_) {
+		stats_->crossings++;
+		stats_->evaluations += eval_.evaluations() - evaluations;
+	}
+
+	if (sin_prev < sin_elev) {
+		result_.jd_start = c.jd;
+		if (result_.jd_start > 0) {
+			topocentric_t topo = eval_.look(result_.jd_start);
+			result_.azm_start = topo.azimuth;
+			result_.elev_start = topo.elevation;
+		}
+
+		return false;
+	}
+
+	bool ended = false;
+	if (result_.jd_start > 0) {
+
+		result_.jd_end = c.jd;
+		if (result_.jd_end > 0) {
+			topocentric_t topo = eval_.look(result_.jd_end);
+			result_.azm_end = topo.azimuth;
+			result_.elev_end = topo.elevation;
+
+			culmination_t top = find_culmination(eval_, result_.jd_start, result_.jd_end);
+			if (stats_) {
+				stats_->culminations++;
+				stats_->culmination_evaluations += top.evaluations;
+			}
+
+			if (top.jd > 0) {
+				result_.jd_max = top.jd;
+				topo = eval_.look(result_.jd_max);
+				result_.azm_max = topo.azimuth;
+				result_.elev_max = topo.elevation;
+				if (eval_.error() == 0) {
+					pass_ = result_;
+					ended = true;
+				}
+			}
+		}
+	}
+
+	result_.jd_start = 0;
+	result_.jd_end = 0;
+
+	return ended;
+}
+
+pass_cursor_t::pass_cursor_t(const sgp4_model& model, const observer_t& observer, double jd_start, double jd_end,
+	pass_scan_stats_t* stats)
+	: model_(model)
+	, observer_(observer)
+	, builder_(model, observer, stats)
+	, stats_(stats)
+	, tle_date_(epoch_jd(model))
+	, jd_end_(jd_end)
+	, step_(std::min(2.0 * M_PI / (model.meta.no_kozai * 1440) / grid_per_rev, grid_step_max))
+	, sidereal_((tle_date_ > jd_start) ? tle_date_ : jd_start, step_, observer.geo.lon) {
+	double jd_first = (tle_date_ > jd_start) ? tle_date_ : jd_start;
+	prev_.jd = jd_first;
+	finished_ = jd_first >= jd_end;
+	if (is_geostationary(model)) {	// geostationary satellites are ignored
+		prev_.jd = jd_end;
+		finished_ = true;
+	}
+
+	double rev_per_day = model.meta.no_kozai * 1440 / (2.0 * M_PI);	// (rev/day)
+
+	// the central angle between the observer and the satellite changes at most by the
+	// angular rate of the satellite at perigee plus the rotation of the earth, 10% margin
+	double e = model.near.ecco;
+	rate_max_ = 1.1 * (2.0 * M_PI * rev_per_day * sqr(1.0 + e) / std::pow(1.0 - e * e, 1.5) + 2.0 * M_PI * 1.0027379);	// (rad/day)
+
+	// the satellite can only be above the horizon within this central angle, 1 deg
+	// margin for the geodetic vertical and the short periodic terms of the radius
+	double rho = observer.position(sidereal_t{ 0.0, 0.0, 1.0 }).mag();
+	double apogee = (1.0 + model.meta.alta) * model.near.radiusearthkm;
+	reach_ = (rho < apogee ? std::acos(rho / apogee) : 0.0) + M_PI / 180.0;
+
+	// two samples at most a grid step apart, both farther than this, cannot hide a pass
+	cos_far_ = std::cos(std::min(M_PI, reach_ + rate_max_ * step_ / 2.0));
+
+	if (!finished_) {
+		grid_count_ = (size_t)std::ceil((jd_end - jd_first) / step_);
+		jd_chunk_ = jd_first;
+	}
+}
+
+pass_cursor_t::sample_t pass_cursor_t::_sample(double jd, const sidereal_t& st, const vector_t& pos, const vector_t& vel) const {
+	vector_t site = observer_.position(st);
+
+	return sample_t{ jd, pos, vel, st, observer_.sin_elevation(st, pos), site.dot(pos), site.dot(site) * pos.dot(pos) };
+}
+
+bool pass_cursor_t::_next(sample_t& out) {
+	if (grid_next_ == grid_count_) {
+		eci_pos_t sat = get_sat_pos((jd_end_ - tle_date_) * 1440, model_, state_);
+		if (state_.error != 0)
+			return false;
+
+		if (stats_)
+			stats_->samples++;
+
+		out = _sample(jd_end_, observer_.sidereal(jd_end_), sat.pos, sat.vel);
+
+		return true;
+	}
+
+	if (chunk_next_ == chunk_count_) {
+		// the chunks double up to grid_chunk : the first passes only cost the samples up to them
+		jd_chunk_ = jd_chunk_ + (double)chunk_count_ * step_;
+		chunk_count_ = std::min({ std::max<size_t>(2 * chunk_count_, 1), grid_chunk, grid_count_ - grid_next_ });
+		chunk_next_ = 0;
+
+		if (model_.near.method == 'd' || chunk_count_ < (size_t)SGP4_BATCH_LANES) {
+			// the deep space integrator goes on from the previous sample, and the first
+			// chunks do not fill the lanes
+			for (size_t k = 0; k < chunk_count_; k++) {
+				eci_pos_t sat = get_sat_pos((jd_chunk_ + (double)k * step_ - tle_date_) * 1440, model_, state_);
+				track_[k] = grid_sample_t{ sat.pos, sat.vel, state_.error };
+			}
+		}
+		else {
+			// the lanes of a batch of one, reused by the cursors of the thread
+			thread_local sgp4_batch_t batch;
+			thread_local sgp4_batch_result_t res;
+			batch.clear();
+			batch.add(model_);
+			batch.propagate_grid(jd_chunk_, step_, chunk_count_, res);
+			for (size_t k = 0; k < chunk_count_; k++)
+				track_[k] = grid_sample_t{ vector_t{ res.x[k], res.y[k], res.z[k] }, vector_t{ res.vx[k], res.vy[k], res.vz[k] }, res.error[k] };
+		}
+
+		if (stats_)
+			stats_->samples += chunk_count_;
+	}
+
+	const grid_sample_t& sample = track_[chunk_next_];
+	if (sample.error != 0)
+		return false;
+
+	if (grid_next_++ > 0)
+		sidereal_.next();
+
+	out = _sample(jd_chunk_ + (double)chunk_next_++ * step_, sidereal_.current(), sample.pos, sample.vel);
+
+	return true;
+}
+
+double pass_cursor_t::_guess(const sample_t& a, const sample_t& b) const {
+	const double h = b.jd - a.jd;
+	const vector_t ta = a.vel * (86400.0 * h);
+	const vector_t tb = b.vel * (86400.0 * h);
+
+	// elevation sine along the cubic, the sidereal angle turned from the one of a
+	auto sin_elev = [&](double s) {
+		double s2 = s * s;
+		double s3 = s2 * s;
+		vector_t pos = a.pos * (2.0 * s3 - 3.0 * s2 + 1.0) + ta * (s3 - 2.0 * s2 + s)
+			+ b.pos * (3.0 * s2 - 2.0 * s3) + tb * (s3 - s2);
+
+		double turn = 2.0 * M_PI * OMEGA_E * s * h;
+		double sin_turn = std::sin(turn);
+		double cos_turn = std::cos(turn);
+		sidereal_t st{ a.st.theta + turn, a.st.sin_theta * cos_turn + a.st.cos_theta * sin_turn,
+			a.st.cos_theta * cos_turn - a.st.sin_theta * sin_turn };
+
+		return observer_.sin_elevation(st, pos);
+	};
+
+	// same Illinois steps as find_crossing, down to 0.1 s
+	double sa = 0.0, fa = a.sin_elev;
+	double sb = 1.0, fb = b.sin_elev;
+	for (int i = 0; i < 20 && std::fabs(sb - sa) * h > 0.1 / 86400.0; i++) {
+		double s = (sa * fb - sb * fa) / (fb - fa);
+		double f = sin_elev(s);
+		if (f == 0.0)
+			return a.jd + s * h;
+
+		if (f * fb < 0.0) {
+			sa = sb;
+			fa = fb;
+		}
+		else
+			fa /= 2;
+
+		sb = s;
+		fb = f;
+	}
+
+	return a.jd + (std::fabs(fa) < std::fabs(fb) ? sa : sb) * h;
+}
+
+double pass_cursor_t::_split(const sample_t& a, const sample_t& b) const {
+	const double step_min = 20.0 / 86400.0;
+
+	if (b.jd - a.jd <= step_min)
+		return 0.0;
+
+	if (beyond(a.dot, a.norms, cos_far_) && beyond(b.dot, b.norms, cos_far_))
+		return 0.0;
+
+	// the satellite leaves a at most at rate_max_ and has to reach b
+	double gap_a = std::acos(std::clamp(a.dot / std::sqrt(a.norms), -1.0, 1.0)) - reach_;
+	double gap_b = std::acos(std::clamp(b.dot / std::sqrt(b.norms), -1.0, 1.0)) - reach_;
+	if (gap_a + gap_b > rate_max_ * (b.jd - a.jd))
+		return 0.0;
+
+	// middle of the dates the satellite can be within reach, in the middle half of the interval
+	double lo = a.jd + std::max(gap_a, 0.0) / rate_max_;
+	double hi = b.jd - std::max(gap_b, 0.0) / rate_max_;
+	double quarter = (b.jd - a.jd) / 4.0;
+
+	return std::clamp((lo + hi) / 2.0, a.jd + quarter, b.jd - quarter);
+}
+
+bool pass_cursor_t::step() {
+	if (finished_)
+		return false;
+
+	if (pending_count_ == 0) {
+		if (!_next(pending_[0])) {
+			finished_ = true;
+			return false;
+		}
+		pending_count_ = 1;
+	}
+
+	const sample_t& next = pending_[pending_count_ - 1];
+
+	// the samples in between come first
+	if (scanned_ && prev_.sin_elev < 0.0 && next.sin_elev < 0.0) {
+		double jd = _split(prev_, next);
+		if (jd > 0) {
+			eci_pos_t sat = get_sat_pos((jd - tle_date_) * 1440, model_, state_);
+			if (state_.error != 0) {
+				finished_ = true;
+				return false;
+			}
+
+			if (stats_)
+				stats_->samples++;
+
+			pending_[pending_count_++] = _sample(jd, observer_.sidereal(jd), sat.pos, sat.vel);
+
+			return false;
+		}
+	}
+
+	bool ended = false;
+	if (scanned_ && next.sin_elev * prev_.sin_elev < 0.0)	// zero crossing
+		ended = builder_.crossing(prev_.jd, prev_.sin_elev, next.jd, next.sin_elev, _guess(prev_, next));
+
+	prev_ = next;
+	pending_count_--;
+	scanned_ = true;
+	if (pending_count_ == 0 && prev_.jd >= jd_end_)
+		finished_ = true;
+
+	return ended;
+}
+
+double pass_cursor_t::known() const {
+	// a pass in progress started at its aos, else the satellite was below the horizon at the last sample
+	return builder_.aos() > 0 ? builder_.aos() : prev_.jd;
+}
+
+std::vector<pass_t> find_passes(const sgp4_model& model, const observer_t& observer, double jd_start, double jd_end,
+	std::stop_token stop, pass_scan_stats_t* stats, const pass_fn& found) {
+	std::vector<pass_t> passes;
+	pass_cursor_t cursor(model, observer, jd_start, jd_end, stats);
+	while (!cursor.finished() && !stop.stop_requested()) {
+		if (cursor.step()) {
+			passes.push_back(cursor.pass());
+			if (found)
+				found(cursor.pass());
+		}
+	}
+
+	return passes;
+}
+
+std::vector<pass_t> find_passes_fixed_step(const sgp4_model& model, const observer_t& observer, double jd_start, double jd_end,
+	int samples_per_rev, pass_scan_stats_t* stats) {
+	std::vector<pass_t> passes;
+	if (is_geostationary(model))
+		return passes; // geostationary satellites are ignored
+
+	double tle_date = epoch_jd(model);
+	double rev_per_day = model.meta.no_kozai * 1440 / (2.0 * M_PI);	// (rev/day)
+	double step = 1.0 / rev_per_day / samples_per_rev;
+
+	double jd_first = (tle_date > jd_start) ? tle_date : jd_start;
+	if (jd_first >= jd_end)
+		return passes;
+
+	// all the samples of the window are propagated in one call
+	size_t count = (size_t)std::ceil((jd_end - jd_first) / step);
+	sgp4_batch_result_t track;
+	sgp4_batch_t::propagate_grid(model, jd_first, step, count, track);
+
+	pass_builder_t builder(model, observer, stats);
+	double previous_elev = 0.0;
+	sidereal_grid_t sidereal(jd_first, step, observer.geo.lon);
+
+	size_t k = 0;
+	for (; k < count; k++) {
+		if (track.error[k] != 0)
+			break;
+
+		double jd = jd_first + (double)k * step;
+		if (k > 0)
+			sidereal.next();
+
+		// only the sign of the elevation and its direction of change are needed
+		double elevation = observer.sin_elevation(sidereal.current(), vector_t{ track.x[k], track.y[k], track.z[k] });
+
+		if (k > 0 && elevation * previous_elev < 0.0 && builder.crossing(jd - step, previous_elev, jd, elevation))	// zero crossing
+			passes.push_back(builder.pass());
+
+		previous_elev = elevation;
+	}
+
+	if (stats)
+		stats->samples += k;
+
+	return passes;
+}
+
+pass_predictor_t::pass_predictor_t(thread_pool_t& pool)
+	: pool_(pool) {
+}
+
+pass_predictor_t::~pass_predictor_t() {
+	cancel();
+	wait();
+}
+
+void pass_predictor_t::start(std::vector<const sgp4_model*> models, const observer_t& observer, double jd_start, double jd_end,
+	double min_elevation, progress_fn progress, found_fn found) {
+	std::vector<double> jd_starts(models.size(), jd_start);
+	start(std::move(models), std::move(jd_starts), observer, jd_end, min_elevation, std::move(progress), std::move(found));
+}
+
+void pass_predictor_t::start(std::vector<const sgp4_model*> models, std::vector<double> jd_starts, const observer_t& observer, double jd_end,
+	double min_elevation, progress_fn progress, found_fn found) {
+	cancel();
+	wait();
+
+	auto run = std::make_shared<run_t>();
+	run->models = std::move(models);
+	run->observer = observer;
+	run->jd_starts = std::move(jd_starts);
+	run->jd_end = jd_end;
+	run->progress = std::move(progress);
+	run->found = std::move(found);
+	run->ranges.resize(run->models.size());
+	run->known.resize(run->models.size());
+
+	for (size_t i = 0; i < run->models.size(); i++) {
+		if (can_rise(*run->models[i], observer, min_elevation))
+			run->scan.push_back(i);
+		else
+			run->known[i] = jd_end;	// no pass to find
+	}
+	run->eliminated = run->models.size() - run->scan.size();
+	run->done = run->eliminated;
+
+	run_ = run;
+
+	// one job per thread, each of them takes the next satellite until none is left
+	size_t jobs = std::min(pool_.size(), run->scan.size());
+	run->jobs = jobs;
+	run->records.resize(jobs);
+	for (size_t j = 0; j < jobs; j++) {
+		pool_.push([run, j] {
+			_work(*run, j);
+
+			std::lock_guard<std::mutex> lock(run->mutex);
+			if (--run->jobs == 0)
+				run->finished.notify_all();
+		});
+	}
+}
+
+void pass_predictor_t::_work(run_t& run, size_t job) {
+	std::stop_token stop = run.stop.get_token();
+	const size_t total = run.models.size();
+	std::vector<pass_record_t>& records = run.records[job];
+
+	for (size_t k = run.next++; k < run.scan.size(); k = run.next++) {
+		if (stop.stop_requested())
+			return;
+
+		size_t i = run.scan[k];
+		size_t begin = records.size();
+		pass_cursor_t cursor(*run.models[i], run.observer, run.jd_starts[i], run.jd_end);
+		while (!cursor.finished() && !stop.stop_requested()) {
+			if (cursor.step()) {
+				records.push_back(pass_record_t{ cursor.pass(), (uint32_t)i });
+				if (run.found)
+					run.found(i, cursor.pass());
+			}
+		}
+		run.ranges[i] = range_t{ job, begin, records.size() };
+		if (cursor.finished())
+			run.known[i] = cursor.known();
+
+		size_t done = ++run.done;
+		if (run.progress)
+			run.progress(i, done, total);
+	}
+}
+
+void pass_predictor_t::cancel() {
+	if (run_)
+		run_->stop.request_stop();
+}
+
+void pass_predictor_t::wait() {
+	if (!run_)
+		return;
+
+	std::unique_lock<std::mutex> lock(run_->mutex);
+	run_->finished.wait(lock, [&] { return run_->jobs == 0; });
+}
+
+bool pass_predictor_t::running() const {
+	if (!run_)
+		return false;
+
+	std::lock_guard<std::mutex> lock(run_->mutex);
+
+	return run_->jobs != 0;
+}
+
+void pass_predictor_t::merge(std::vector<pass_record_t>& out) const {
+	std::vector<std::span<const pass_record_t>> runs;
+	runs.reserve(size());
+	for (size_t i = 0; i < size(); i++) {
+		runs.push_back(passes(i));
+	}
+
+	merge_passes(runs, out);
+}
+
+pass_generator_t::pass_generator_t(std::vector<const sgp4_model*> models, const observer_t& observer, double jd_start, double jd_end,
+	double min_elevation)
+	: observer_(observer)
+	, min_elevation_(min_elevation) {
+	cursors_.reserve(models.size());
+	for (size_t i = 0; i < models.size(); i++) {
+		cursors_.emplace_back(*models[i], observer_, jd_start, jd_end, &stats_);
+		if (can_rise(*models[i], observer_, min_elevation) && !cursors_[i].finished())
+			queue_.push(entry_t{ cursors_[i].known(), (uint32_t)i, false });
+	}
+}
+
+bool pass_generator_t::next(pass_record_t& out) {
+	while (!queue_.empty()) {
+		entry_t e = queue_.top();
+		queue_.pop();
+
+		// the passes of the other satellites start after e.jd
+		pass_cursor_t& cursor = cursors_[e.sat];
+		if (e.ready) {
+			out = pass_record_t{ cursor.pass(), e.sat };
+			if (!cursor.finished())
+				queue_.push(entry_t{ cursor.known(), e.sat, false });
+
+			if (out.pass.elev_max >= min_elevation_)
+				return true;
+
+			continue;
+		}
+
+		if (cursor.step())
+			queue_.push(entry_t{ cursor.pass().jd_start, e.sat, true });
+		else if (!cursor.finished())
+			queue_.push(entry_t{ cursor.known(), e.sat, false });
+	}
+
+	return false;
+}
+
+bool pass_predictor_t::canceled() const {
+	return run_ && run_->stop.stop_requested();
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <stop_token>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+#include "sat_calc.h"
+#include "thread_pool.h"
+
+// One pass of a satellite above the horizon of the observer
+struct pass_t {
+	double jd_start;
+	double jd_max;	// highest elevation, by find_culmination
+	double jd_end;
+
+	double azm_start;
+	double azm_max;
+	double azm_end;
+
+	double elev_start;
+	double elev_max;
+	double elev_end;
+};
+
+// pass of one of several satellites, sat : its index in the models of the search
+struct pass_record_t {
+	pass_t pass;
+	uint32_t sat;
+};
+
+// runs of passes sorted by start date merged into out, by start date then satellite.
+// The run heads are kept on a heap : n log(runs) comparisons and out allocated once
+void merge_passes(const std::vector<std::span<const pass_record_t>>& runs, std::vector<pass_record_t>& out);
+
+// false when the satellite can never be seen above min_elevation (rad) from the
+// observer : its ground track stays too far from the observer latitude for its
+// inclination and apogee radius. No propagation, the bound keeps a 2 deg margin
+// for the perturbations of the mean elements
+bool can_rise(const sgp4_model& model, const observer_t& observer, double min_elevation);
+
+// work of the pass searches, added to by each search
+struct pass_scan_stats_t {
+	size_t samples{};		// propagations of the scan, crossings refinement excluded
+	size_t crossings{};		// horizon crossings refined by find_crossing
+	size_t evaluations{};	// propagations of the refinements
+	size_t culminations{};	// highest points searched by find_culmination
+	size_t culmination_evaluations{};
+};
+
+// called with each pass as soon as its end is found
+using pass_fn = std::function<void(const pass_t& pass)>;
+
+// turns the horizon crossings of a scan into passes
+class pass_builder_t {
+public:
+	pass_builder_t(const sgp4_model& model, const observer_t& observer, pass_scan_stats_t* stats = nullptr)
+		: eval_(model, observer)
+		, stats_(stats) {
+	}
+
+	// the elevation changed sign between jd_prev and jd, with the elevation sines of the scan.
+	// guess : estimate of the crossing date, its propagation narrows the search, 0 for none.
+	// true when it ended a pass, given by pass()
+	bool crossing(double jd_prev, double sin_prev, double jd, double sin_elev, double guess = 0.0);
+
+	const pass_t& pass() const {
+		return pass_;
+	}
+
+	// start of the pass in progress, 0 when the satellite is below the horizon
+	double aos() const {
+		return result_.jd_start;
+	}
+
+private:
+	elevation_eval_t eval_;
+	pass_scan_stats_t* stats_;
+
+	pass_t result_{};
+	pass_t pass_{};
+};
+
+// adaptive scan of find_passes, one sample at a time. The model and the observer
+// must outlive the cursor
+class pass_cursor_t {
+public:
+	pass_cursor_t(const sgp4_model& model, const observer_t& observer, double jd_start, double jd_end,
+		pass_scan_stats_t* stats = nullptr);
+
+	// true when the sample ended a pass, given by pass()
+	bool step();
+
+	const pass_t& pass() const {
+		return builder_.pass();
+	}
+
+	// end of the window, or failed propagation
+	bool finished() const {
+		return finished_;
+	}
+
+	// the passes starting before this date were all ended by step()
+	double known() const;
+
+private:
+	// elevation sine of a sample, and the central angle between the observer and the
+	// satellite as their dot product and the product of their squared norms
+	struct sample_t {
+		double jd;
+		vector_t pos;	// (km)
+		vector_t vel;	// (km/s)
+		sidereal_t st;
+		double sin_elev;
+		double dot;
+		double norms;
+	};
+
+	sample_t _sample(double jd, const sidereal_t& st, const vector_t& pos, const vector_t& vel) const;
+
+	// next sample of the grid, then the end of the window. false when the propagation failed
+	bool _next(sample_t& out);
+
+	// crossing date of the elevation sine along the cubic between two samples
+	double _guess(const sample_t& a, const sample_t& b) const;
+
+	// date to split the interval between two samples below the horizon at, 0 when the
+	// satellite cannot rise between them
+	double _split(const sample_t& a, const sample_t& b) const;
+
+	const sgp4_model& model_;
+	const observer_t& observer_;
+	pass_builder_t builder_;
+	pass_scan_stats_t* stats_;
+	sgp4_state state_{};
+
+	double tle_date_;
+	double jd_end_;
+	double step_;		// of the grid
+	double rate_max_;	// (rad/day)
+	double reach_;		// (rad)
+	double cos_far_;	// cosine of reach_ + rate_max_ * step_ / 2
+
+	// samples of the grid before jd_end, propagated grid_chunk at a time
+	static constexpr size_t grid_chunk = 16;
+
+	struct grid_sample_t {
+		vector_t pos;	// (km)
+		vector_t vel;	// (km/s)
+		int error;
+	};
+
+	grid_sample_t track_[grid_chunk]{};
+	sidereal_grid_t sidereal_;
+	double jd_chunk_{};	// date of track_ sample 0, jd_chunk_ + k * step_ for sample k
+	size_t grid_count_{};
+	size_t grid_next_{};
+	size_t chunk_next_{};
+	size_t chunk_count_{};
+
+	// a split leaves at most 3/4 of the interval on either side : from a grid step of 4 h
+	// down to 20 s, 23 splits deep at most
+	static constexpr size_t pending_max = 24;
+
+	sample_t prev_{};	// last sample scanned, its date only before the first one
+	sample_t pending_[pending_max]{};	// samples after prev_ not scanned yet, the earliest last
+	size_t pending_count_{};
+	bool scanned_{};
+	bool finished_{};
+};
+
+// passes of model seen by observer between jd_start and jd_end, in time order.
+// The scan propagates a grid of 1/6 of the period, 4 h at most, with the batch kernel.
+// Between two samples below the horizon, the satellite would need, at its largest
+// angular rate, the time to come within sight of the observer and back : when the
+// interval is long enough for that, it is split, down to 20 s. The horizon crossings
+// are searched from a first date on the cubic through the positions and velocities
+// of the samples.
+// Returns early, with the passes found so far, when stop is requested
+std::vector<pass_t> find_passes(const sgp4_model& model, const observer_t& observer, double jd_start, double jd_end,
+	std::stop_token stop = {}, pass_scan_stats_t* stats = nullptr, const pass_fn& found = {});
+
+// same with a fixed step of 1/samples_per_rev of the period, the former scan kept as reference
+std::vector<pass_t> find_passes_fixed_step(const sgp4_model& model, const observer_t& observer, double jd_start, double jd_end,
+	int samples_per_rev = 20, pass_scan_stats_t* stats = nullptr);
+
+// Passes of several satellites by start date, computed on demand. A priority queue
+// holds the date each satellite is known up to, only the earliest one is scanned
+// further : the next few passes cost the propagations up to their dates, not the
+// whole window. Satellites which cannot rise above min_elevation (rad) and lower
+// passes are left out. The models must outlive the generator
+class pass_generator_t {
+public:
+	pass_generator_t(std::vector<const sgp4_model*> models, const observer_t& observer, double jd_start, double jd_end,
+		double min_elevation = 0.0);
+
+	pass_generator_t(const pass_generator_t&) = delete;
+	pass_generator_t& operator=(const pass_generator_t&) = delete;
+
+	// next pass by start date, false once the window is over. sat : index in models
+	bool next(pass_record_t& out);
+
+	// work of the scans so far
+	const pass_scan_stats_t& stats() const {
+		return stats_;
+	}
+
+private:
+	struct entry_t {
+		double jd;	// known() of the satellite, or start of its ended pass
+		uint32_t sat;
+		bool ready;	// the pass of the cursor is the next one of the satellite
+	};
+
+	// std::priority_queue keeps the largest on top
+	struct later_t {
+		bool operator()(const entry_t& a, const entry_t& b) const {
+			return a.jd > b.jd;
+		}
+	};
+
+	observer_t observer_;	// the cursors refer to it
+	double min_elevation_;
+	pass_scan_stats_t stats_;
+	std::vector<pass_cursor_t> cursors_;
+	std::priority_queue<entry_t, std::vector<entry_t>, later_t> queue_;
+};
+
+// Pass predictions of several satellites for one observer, computed on a thread pool.
+// start() returns at once : the pool threads take the satellites one at a time, so a
+// thread done with a short list of cheap satellites takes over the remaining ones.
+// Satellites which cannot rise above min_elevation are dropped by can_rise() first,
+// they count as done with no pass.
+// The progress callback is called by the worker thread which finished a satellite, the
+// found callback by the worker thread which found a pass, as soon as its end is known.
+// Each job appends the passes of its satellites to its own vector of records, merge()
+// puts them in date order once the run is finished.
+class pass_predictor_t {
+public:
+	// sat : index in the models given to start(), done : satellites finished so far
+	using progress_fn = std::function<void(size_t sat, size_t done, size_t total)>;
+	using found_fn = std::function<void(size_t sat, const pass_t& pass)>;
+
+	explicit pass_predictor_t(thread_pool_t& pool);
+
+	// cancels and waits for the running predictions
+	~pass_predictor_t();
+
+	pass_predictor_t(const pass_predictor_t&) = delete;
+	pass_predictor_t& operator=(const pass_predictor_t&) = delete;
+
+	// cancels the previous run. The models must stay alive until the run is finished
+	void start(std::vector<const sgp4_model*> models, const observer_t& observer, double jd_start, double jd_end,
+		double min_elevation = 0.0, progress_fn progress = {}, found_fn found = {});
+
+	// same, satellite i scanned from jd_starts[i]
+	void start(std::vector<const sgp4_model*> models, std::vector<double> jd_starts, const observer_t& observer, double jd_end,
+		double min_elevation = 0.0, progress_fn progress = {}, found_fn found = {});
+
+	// the workers stop at their next sample, the passes found so far are kept
+	void cancel();
+
+	void wait();
+
+	bool running() const;
+
+	bool canceled() const;
+
+	size_t size() const {
+		return run_ ? run_->models.size() : 0;
+	}
+
+	size_t done() const {
+		return run_ ? run_->done.load() : 0;
+	}
+
+	// satellites dropped by can_rise()
+	size_t eliminated() const {
+		return run_ ? run_->eliminated : 0;
+	}
+
+	// passes of satellite i in time order, once the run is finished
+	std::span<const pass_record_t> passes(size_t i) const {
+		if (!run_)
+			return {};	// never started
+
+		const range_t& r = run_->ranges[i];
+		if (r.begin == r.end)
+			return {};	// no pass, or not scanned
+
+		return std::span<const pass_record_t>(run_->records[r.job]).subspan(r.begin, r.end - r.begin);
+	}
+
+	// passes of all the satellites by start date, once the run is finished
+	void merge(std::vector<pass_record_t>& out) const;
+
+	// pass_cursor_t::known() at the end of the scan of satellite i, jd_end for the
+	// satellites can_rise() dropped, 0 when the scan was canceled or nothing was started
+	double known(size_t i) const {
+		return run_ ? run_->known[i] : 0.0;
+	}
+
+private:
+	// passes of one satellite in the records of one job
+	struct range_t {
+		size_t job;
+		size_t begin;
+		size_t end;
+	};
+
+	// state shared with the jobs
+	struct run_t {
+		std::vector<const sgp4_model*> models;
+		observer_t observer;
+		std::vector<double> jd_starts;	// by satellite
+		double jd_end;
+		progress_fn progress;
+		found_fn found;
+
+		std::vector<std::vector<pass_record_t>> records;	// by job
+		std::vector<range_t> ranges;	// by satellite
+		std::vector<double> known;		// by satellite
+		std::vector<size_t> scan;	// satellites left by can_rise()
+		size_t eliminated{};
+		std::atomic<size_t> next{};
+		std::atomic<size_t> done{};
+		std::stop_source stop;
+
+		size_t jobs{};	// jobs still running, under mutex
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	static void _work(run_t& run, size_t job);
+
+	thread_pool_t& pool_;
+	std::shared_ptr<run_t> run_;
+};
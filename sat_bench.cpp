@@ -0,0 +1,1802 @@
+// Standalone verification and benchmark of the propagation code, not part of the plugin build.
+//
+//   g++ -std=c++20 -O2 -pthread sat_bench.cpp SGP4.cpp sat_calc.cpp sgp4_batch.cpp sat_catalog.cpp thread_pool.cpp sat_clock.cpp pass_predictor.cpp pass_cache.cpp sat_ephemeris.cpp -o sat_bench
+//
+// First checks the SGP4-VER reference vectors, near earth and deep space, through
+// parse_tle_lines and every propagation path : elsetrec, sgp4_model and the batch
+// kernel, deep space on both sides of the epoch and a decay error. The program exits
+// with 1 when one of them is off, before any timing.
+// Then times sgp4init and the propagation, in ns and in satellites x steps per second,
+// and the parallel loading of a 25000 objects catalog.
+// Reports the memory traffic of one near earth propagation with the full elsetrec
+// and with the compact elsetrec_near record, then times a catalog sweep with both, and
+// single satellites over a time grid with the scalar loop and the batch kernel.
+// Checks the closed form geodetic conversion against the iterative one over the
+// altitudes of the bundled tle files, and the error estimates of the Chebyshev
+// ephemeris against sgp4 at random times.
+// Counts the allocations of the passes of 7 days of 200 satellites put in date order.
+// Checks the lazy pass generator against one whole day of passes.
+// Times the pass cache of the predictions dialog : reopened with the same inputs, read
+// back from a file, with the window moved forward and with new elements.
+// Also times random access queries on resonant deep space orbits, with and without
+// the integrator checkpoints of sgp4_state.
+
+#include <cstdio>
+#include <cstddef>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <set>
+#include <utility>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <span>
+#include <new>
+#include <cstdlib>
+
+#include "SGP4.h"
+#include "sat_calc.h"
+#include "sgp4_batch.h"
+#include "sat_catalog.h"
+#include "sat_clock.h"
+#include "pass_predictor.h"
+#include "pass_cache.h"
+#include "sat_ephemeris.h"
+#include "mpsc_queue.h"
+
+using namespace SGP4Funcs;
+
+// allocations of the whole program, counted by the replaced operator new
+static std::atomic<size_t> allocations{};
+
+// the replaced operators only call this pair : the compiler sees no free() of a
+// pointer which operator new returned
+static void* counted_alloc(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+static void counted_free(void* p) noexcept {
+	std::free(p);
+}
+
+void* operator new(size_t size) {
+	return counted_alloc(size);
+}
+
+void operator delete(void* p) noexcept {
+	counted_free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	counted_free(p);
+}
+
+// SGP4-VER test tles
+static const char* const tle_00005[2] = {
+	"1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753",
+	"2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667" };
+static const char* const tle_06251[2] = {
+	"1 06251U 62025E   06176.82412014  .00008885  00000-0  12808-3 0  3985",
+	"2 06251  58.0579  54.0425 0030035 139.1568 221.1854 15.56387291  6774" };
+static const char* const tle_28057[2] = {
+	"1 28057U 03049A   06177.78615833  .00000060  00000-0  35940-4 0  1836",
+	"2 28057  98.4283 247.6961 0000884  88.1964 271.9322 14.35478080140550" };
+static const char* const tle_08195[2] = {
+	"1 08195U 75081A   06176.33215444  .00000099  00000-0  11873-3 0   813",
+	"2 08195  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656" };
+static const char* const tle_09880[2] = {
+	"1 09880U 77021A   06176.56157475  .00000421  00000-0  10000-3 0  9814",
+	"2 09880  64.5968 349.3786 7069051 270.0229  16.3320  2.00813614112380" };
+static const char* const tle_28626[2] = {
+	"1 28626U 05008A   06176.46683397 -.00000205  00000-0  10000-3 0  2190",
+	"2 28626   0.0019 286.9433 0000335  13.7918  55.6504  1.00270176  4891" };
+
+static const char* const* const ref_tles[] = { tle_00005, tle_06251, tle_28057, tle_08195, tle_09880, tle_28626 };
+
+// reference TEME state vectors of the SGP4-VER test cases, wgs72 (km, km/s), or the
+// error code sgp4 has to return
+struct ref_case_t {
+	const char* const* tle;
+	double tsince;	// (min)
+	double r[3];
+	double v[3];
+	int error = 0;
+};
+
+static const ref_case_t ref_cases[] = {
+	{ tle_00005, 0.0, { 7022.46529266, -1400.08296755, 0.03995155 }, { 1.893841015, 6.405893759, 4.534807250 } },
+	{ tle_00005, 360.0, { -7154.03120202, -3783.17682504, -3536.19412294 }, { 4.741887409, -4.151817765, -2.093935425 } },
+	{ tle_06251, 0.0, { 3988.31022699, 5498.96657235, 0.90055879 }, { -3.290032738, 2.357652820, 6.496623475 } },
+	{ tle_28057, 0.0, { -2715.28237486, -6619.26436889, -0.01341443 }, { -1.008587273, 0.422782003, 7.385272942 } },
+	// perigee below the surface some 7.6 years after the epoch : decayed, error 6
+	{ tle_06251, 4000000.0, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, 6 },
+	// deep space, both sides of the epoch across several resonance integration steps :
+	// 12h resonance (molniya), then geosynchronous
+	{ tle_08195, -1440.0, { 1795.04933268, -14049.70061318, -947.43454031 }, { 2.784637180, -3.643927317, 4.486405513 } },
+	{ tle_08195, -720.0, { 2074.17053788, -14427.80727238, -474.16310822 }, { 2.753721857, -3.445103511, 4.495891434 } },
+	{ tle_08195, 0.0, { 2349.89483350, -14785.93811562, 0.02119378 }, { 2.721488096, -3.256811655, 4.498416672 } },
+	{ tle_08195, 360.0, { 19089.29762968, 3107.89495018, 39958.14661370 }, { -0.410308034, 1.640332277, -0.306873818 } },
+	{ tle_08195, 720.0, { 2622.13222207, -15125.15464924, 474.51048398 }, { 2.688287199, -3.078426664, 4.494979530 } },
+	{ tle_08195, 1440.0, { 2890.80638268, -15446.43952300, 948.77010176 }, { 2.654407490, -2.909344895, 4.486437362 } },
+	{ tle_08195, 2880.0, { 3417.20931586, -16038.79510665, 1894.74934058 }, { 2.585515864, -2.596818146, 4.456882556 } },
+	{ tle_09880, -1440.0, { 11403.93747183, -2948.56452874, -1716.42673801 }, { 5.099900445, 1.417013656, 4.893255031 } },
+	{ tle_09880, -720.0, { 12248.61754413, -2706.19069954, -860.47108067 }, { 4.653502605, 1.518846255, 4.942548254 } },
+	{ tle_09880, 0.0, { 13020.06750784, -2449.07193500, 1.15896030 }, { 4.247363935, 1.597178501, 4.956708611 } },
+	{ tle_09880, 360.0, { 328.74217398, 19554.92047380, 40558.26246145 }, { -1.593281066, 0.126772913, -0.359627307 } },
+	{ tle_09880, 720.0, { 13725.09398980, -2180.70877090, 863.29684523 }, { 3.878478111, 1.656846496, 4.944867241 } },
+	{ tle_09880, 1440.0, { 14369.90303735, -1903.85601062, 1722.15319852 }, { 3.543393116, 1.701687176, 4.913881358 } },
+	{ tle_09880, 2880.0, { 15500.53445068, -1332.90981042, 3419.72315308 }, { 2.960917974, 1.758331634, 4.813698638 } },
+	{ tle_28626, -1440.0, { 42029.05113437, -3368.15990819, 2.95725566 }, { 0.245704559, 3.064928956, 0.000662227 } },
+	{ tle_28626, -720.0, { -42057.70904073, 3012.27865835, -1.78742279 }, { -0.219566194, -3.066792926, -0.000556650 } },
+	{ tle_28626, 0.0, { 42080.71852213, -2646.86387436, 0.81851294 }, { 0.193105177, 3.068688251, 0.000438449 } },
+	{ tle_28626, 360.0, { 2467.44290178, 42093.60909959, 5.15062987 }, { -3.069341800, 0.179976276, -0.000031739 } },
+	{ tle_28626, 720.0, { -42103.20138132, 2291.06228893, -0.13274964 }, { -0.166974816, -3.070104560, -0.000311007 } },
+	{ tle_28626, 1440.0, { 42119.96263499, -1925.77567263, -0.19827433 }, { 0.140521206, 3.071541613, 0.000179561 } },
+	{ tle_28626, 2880.0, { 42146.81714550, -1205.30681787, 0.30657928 }, { 0.087982664, 3.073491493, -0.000068888 } },
+};
+
+// the reference is printed with 8 decimals for the positions, 9 for the velocities
+constexpr double ref_tol_km = 1e-6;
+constexpr double ref_tol_kms = 1e-8;
+
+static double dist3(const double a[3], const double b[3]) {
+	return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+// returns the number of failed checks
+static int verify_reference() {
+	int failed = 0;
+	double max_dr = 0.0, max_dv = 0.0;
+
+	for (auto& c : ref_cases) {
+		elsetrec satrec{};
+		parse_tle_lines(line_pair{ c.tle[0], c.tle[1] }, 'a', wgs72, satrec);
+
+		sgp4_model model;
+		makesgp4model(satrec, model);
+
+		double r[3][3], v[3][3];
+		int error[3];
+
+		sgp4(satrec, c.tsince, r[0], v[0]);
+		error[0] = satrec.error;
+
+		sgp4_state state{};
+		sgp4(model, state, c.tsince, r[1], v[1]);
+		error[1] = state.error;
+
+		sgp4_batch_result_t res;
+		sgp4_batch_t::propagate_minutes(model, &c.tsince, 1, res);
+		r[2][0] = res.x[0]; r[2][1] = res.y[0]; r[2][2] = res.z[0];
+		v[2][0] = res.vx[0]; v[2][1] = res.vy[0]; v[2][2] = res.vz[0];
+		error[2] = res.error[0];
+
+		const char* paths[3] = { "elsetrec", "sgp4_model", "batch" };
+		for (int k = 0; k < 3; k++) {
+			// no state vector to compare when an error is expected
+			double dr = c.error == 0 ? dist3(r[k], c.r) : 0.0;
+			double dv = c.error == 0 ? dist3(v[k], c.v) : 0.0;
+			max_dr = std::max(max_dr, dr);
+			max_dv = std::max(max_dv, dv);
+
+			if (error[k] != c.error || dr > ref_tol_km || dv > ref_tol_kms) {
+				printf("  FAILED %s t=%.1f %-10s : error %d, dr %.3g km, dv %.3g km/s\n",
+					satrec.satnum, c.tsince, paths[k], error[k], dr, dv);
+				failed++;
+			}
+		}
+	}
+
+	size_t checks = 3 * sizeof(ref_cases) / sizeof(ref_cases[0]);
+	printf("reference vectors  : %zu checks, %d failed, max error %.2g km, %.2g km/s\n",
+		checks, failed, max_dr, max_dv);
+	return failed;
+}
+
+static void report_init(size_t reps) {
+	std::vector<line_pair> tles;
+	for (auto tle : ref_tles) {
+		tles.push_back(line_pair{ tle[0], tle[1] });
+	}
+
+	auto time_tles = [&](auto init) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < reps; k++) {
+			for (auto& tle : tles) {
+				init(tle);
+			}
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / (double(reps) * tles.size());
+	};
+
+	// parse_tle_lines ends with sgp4init, the parsed records are initialized again alone
+	std::vector<elsetrec> parsed(tles.size());
+	for (size_t i = 0; i < tles.size(); i++) {
+		parse_tle_lines(tles[i], 'a', wgs72, parsed[i]);
+	}
+
+	elsetrec satrec{};
+	double ns_parse = time_tles([&](const line_pair& tle) {
+		parse_tle_lines(tle, 'a', wgs72, satrec);
+	});
+	double ns_init = time_tles([&](const line_pair& tle) {
+		const elsetrec& p = parsed[&tle - &tles[0]];
+		sgp4init(wgs72, 'a', p.satnum, p.jdsatepoch + p.jdsatepochF - 2433281.5, p.bstar,
+			p.ndot, p.nddot, p.ecco, p.argpo, p.inclo, p.mo, p.no_kozai, p.nodeo, satrec);
+	});
+
+	printf("initialization     : %zu tles x %zu\n", tles.size(), reps);
+	printf("  parse_tle_lines  : %.1f ns/tle, sgp4init included\n", ns_parse);
+	printf("  sgp4init         : %.1f ns/init\n", ns_init);
+}
+
+// pool of the bench, one thread per hardware thread. A static is fine in a program,
+// the plugin owns its pool and stops it before it is unloaded
+static thread_pool_t& bench_pool() {
+	static thread_pool_t pool;
+
+	return pool;
+}
+
+// catalog file of sats objects cycling through the reference tles, loaded with one
+// thread and with the bench pool
+static void report_catalog(size_t sats) {
+	std::string filename = (std::filesystem::temp_directory_path() / "sat_bench_catalog.txt").string();
+	{
+		std::ofstream out(filename);
+		const size_t ntles = sizeof(ref_tles) / sizeof(ref_tles[0]);
+		for (size_t i = 0; i < sats; i++) {
+			out << "SAT " << i << "\n" << ref_tles[i % ntles][0] << "\n" << ref_tles[i % ntles][1] << "\n";
+		}
+	}
+
+	thread_pool_t single(1);
+	sat_catalog_t catalog;
+	catalog.load({ filename }, single);
+	double ms_single = catalog.load_ms();
+
+	size_t ready = catalog.load({ filename }, bench_pool());
+	double ms_pool = catalog.load_ms();
+
+	std::filesystem::remove(filename);
+
+	printf("catalog loading    : %zu objects, %zu ready, %zu failed\n", sats, ready, catalog.failures().size());
+	printf("  1 thread         : %.1f ms, %.2f us/object\n", ms_single, ms_single * 1e3 / sats);
+	printf("  pool             : %.1f ms, %.2f us/object, %zu threads\n", ms_pool, ms_pool * 1e3 / sats, bench_pool().size());
+}
+
+// fields of the record read by sgp4 for method 'n', as (offset, size)
+#define NEAR_FIELD(rec, f) std::make_pair(offsetof(rec, f), sizeof(((rec*)nullptr)->f))
+#define NEAR_FIELDS(rec) { \
+	NEAR_FIELD(rec, mo), NEAR_FIELD(rec, mdot), NEAR_FIELD(rec, argpo), NEAR_FIELD(rec, argpdot), \
+	NEAR_FIELD(rec, nodeo), NEAR_FIELD(rec, nodedot), NEAR_FIELD(rec, nodecf), NEAR_FIELD(rec, bstar), \
+	NEAR_FIELD(rec, cc1), NEAR_FIELD(rec, cc4), NEAR_FIELD(rec, cc5), NEAR_FIELD(rec, t2cof), \
+	NEAR_FIELD(rec, t3cof), NEAR_FIELD(rec, t4cof), NEAR_FIELD(rec, t5cof), NEAR_FIELD(rec, d2), \
+	NEAR_FIELD(rec, d3), NEAR_FIELD(rec, d4), NEAR_FIELD(rec, omgcof), NEAR_FIELD(rec, xmcof), \
+	NEAR_FIELD(rec, eta), NEAR_FIELD(rec, delmo), NEAR_FIELD(rec, sinmao), NEAR_FIELD(rec, no_unkozai), \
+	NEAR_FIELD(rec, ecco), NEAR_FIELD(rec, inclo), NEAR_FIELD(rec, aycof), NEAR_FIELD(rec, xlcof), \
+	NEAR_FIELD(rec, con41), NEAR_FIELD(rec, x1mth2), NEAR_FIELD(rec, x7thm1), NEAR_FIELD(rec, xke), \
+	NEAR_FIELD(rec, j2), NEAR_FIELD(rec, radiusearthkm), NEAR_FIELD(rec, isimp), NEAR_FIELD(rec, method) }
+
+// cache lines covered by the fields when the record starts at byte `align` of a line
+static size_t lines_touched(const std::vector<std::pair<size_t, size_t>>& fields, size_t align) {
+	std::set<size_t> lines;
+	for (auto& f : fields) {
+		lines.insert((align + f.first) / 64);
+		lines.insert((align + f.first + f.second - 1) / 64);
+	}
+	return lines.size();
+}
+
+static void report_bytes() {
+	std::vector<std::pair<size_t, size_t>> full = NEAR_FIELDS(elsetrec);
+	std::vector<std::pair<size_t, size_t>> compact = NEAR_FIELDS(elsetrec_near);
+
+	// sgp4 also stores its results in an elsetrec, they go to the caller's sgp4_state otherwise
+	for (auto f : { NEAR_FIELD(elsetrec, t), NEAR_FIELD(elsetrec, error),
+				    NEAR_FIELD(elsetrec, am), NEAR_FIELD(elsetrec, em), NEAR_FIELD(elsetrec, im),
+				    NEAR_FIELD(elsetrec, Om), NEAR_FIELD(elsetrec, om), NEAR_FIELD(elsetrec, mm),
+				    NEAR_FIELD(elsetrec, nm) }) {
+		full.push_back(f);
+	}
+
+	// an elsetrec is only 8 bytes aligned, average over its possible placements
+	double full_lines = 0.0;
+	for (size_t align = 0; align < 64; align += alignof(elsetrec)) {
+		full_lines += lines_touched(full, align);
+	}
+	full_lines /= 64 / alignof(elsetrec);
+
+	size_t compact_lines = lines_touched(compact, 0);
+
+	printf("record sizes       : elsetrec %zu, elsetrec_near %zu, elsetrec_deep %zu, elsetrec_meta %zu bytes\n",
+		sizeof(elsetrec), sizeof(elsetrec_near), sizeof(elsetrec_deep), sizeof(elsetrec_meta));
+	printf("near earth sgp4    : %zu fields\n", compact.size());
+	printf("  elsetrec         : %.2f cache lines, %.0f bytes touched\n", full_lines, full_lines * 64);
+	printf("  elsetrec_near    : %zu cache lines, %zu bytes touched\n", compact_lines, compact_lines * 64);
+}
+
+// catalog of near earth satellites spread around a sun synchronous orbit
+static std::vector<elsetrec> make_catalog(size_t n) {
+	const double pi = 3.14159265358979323846;
+	const double deg2rad = pi / 180.0;
+	const double xpdotp = 1440.0 / (2.0 * pi);
+
+	std::vector<elsetrec> catalog(n);
+	for (size_t i = 0; i < n; i++) {
+		double inclo = (97.0 + (i % 17) * 0.1) * deg2rad;
+		double nodeo = fmod(i * 7.3, 360.0) * deg2rad;
+		double mo = fmod(i * 13.1, 360.0) * deg2rad;
+		double no = (14.2 + (i % 29) * 0.05) / xpdotp;
+		sgp4init(wgs72, 'i', "00001", 20000.5, 3.5e-5, 0.0, 0.0, 0.0012, 88.0 * deg2rad,
+			inclo, mo, no, nodeo, catalog[i]);
+	}
+	return catalog;
+}
+
+template <class F>
+static double time_sweep(size_t sats, size_t steps, F propagate) {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t k = 0; k < steps; k++) {
+		double tsince = k * 10.0;
+		for (size_t i = 0; i < sats; i++) {
+			propagate(i, tsince);
+		}
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / (double(sats) * steps);
+}
+
+static void report_sweep(size_t sats, size_t steps) {
+	std::vector<elsetrec> full = make_catalog(sats);
+	std::vector<elsetrec_near> compact(sats);
+	for (size_t i = 0; i < sats; i++) {
+		splitelsetrec(full[i], compact[i], nullptr, nullptr);
+	}
+
+	double r[3], v[3];
+	sgp4_state state{};
+	double check_full = 0.0, check_compact = 0.0;
+	double ns_full = time_sweep(sats, steps, [&](size_t i, double t) {
+		sgp4(full[i], t, r, v);
+		check_full += r[0];
+	});
+	double ns_compact = time_sweep(sats, steps, [&](size_t i, double t) {
+		sgp4(compact[i], nullptr, state, t, r, v);
+		check_compact += r[0];
+	});
+
+	// the batch kernel steps the whole catalog to one date at a time
+	sgp4_batch_t batch;
+	batch.reserve(sats);
+	for (auto& satrec : full) {
+		batch.add(satrec);
+	}
+	double jdepoch = full[0].jdsatepoch + full[0].jdsatepochF;
+
+	sgp4_batch_result_t res;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t k = 0; k < steps; k++) {
+		batch.propagate(jdepoch + k * 10.0 / 1440.0, res);
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	double ns_batch = elapsed.count() / (double(sats) * steps);
+
+	// last date of the sweep against the scalar sgp4
+	double max_dr = 0.0;
+	size_t errors = 0;
+	double jd_last = jdepoch + (steps - 1) * 10.0 / 1440.0;
+	for (size_t i = 0; i < sats; i++) {
+		sgp4(full[i], (jd_last - full[i].jdsatepoch - full[i].jdsatepochF) * 1440.0, r, v);
+		double rb[3] = { res.x[i], res.y[i], res.z[i] };
+		errors += (full[i].error != res.error[i]) ? 1 : 0;
+		if (full[i].error == 0)
+			max_dr = std::max(max_dr, dist3(r, rb));
+	}
+
+	printf("catalog sweep      : %zu satellites x %zu steps, %.1f / %.1f kB of records\n",
+		sats, steps, sats * sizeof(elsetrec) / 1024.0, sats * sizeof(elsetrec_near) / 1024.0);
+	printf("  elsetrec         : %.1f ns/prop, %.2f M sat.steps/s\n", ns_full, 1e3 / ns_full);
+	printf("  elsetrec_near    : %.1f ns/prop, %.2f M sat.steps/s%s\n", ns_compact, 1e3 / ns_compact,
+		check_full == check_compact ? "" : "  (results differ!)");
+	printf("  sgp4_batch_t     : %.1f ns/prop, %.2f M sat.steps/s, %.2g km from elsetrec, %zu error codes differ\n",
+		ns_batch, 1e3 / ns_batch, max_dr, errors);
+}
+
+// one satellite over a day of 1 min samples, as the ground track, the fixed step scan
+// and the ephemeris fit do : the scalar sgp4 loop against sgp4_batch_t::propagate_grid
+static void report_grid(size_t sats, size_t samples) {
+	std::vector<elsetrec> full = make_catalog(sats);
+	std::vector<sgp4_model> models(sats);
+	for (size_t i = 0; i < sats; i++) {
+		makesgp4model(full[i], models[i]);
+	}
+
+	std::vector<double> x(samples);
+	double r[3], v[3];
+	sgp4_state state{};
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < sats; i++) {
+		for (size_t k = 0; k < samples; k++) {
+			sgp4(models[i], state, (double)k, r, v);
+			x[k] = r[0];
+		}
+	}
+	std::chrono::duration<double, std::nano> ns_scalar = std::chrono::steady_clock::now() - start;
+
+	sgp4_batch_result_t res;
+	double max_dr = 0.0;
+	std::chrono::duration<double, std::nano> ns_grid{};
+	for (size_t i = 0; i < sats; i++) {
+		double epoch = epoch_jd(models[i]);
+		start = std::chrono::steady_clock::now();
+		sgp4_batch_t::propagate_grid(models[i], epoch, 1.0 / 1440.0, samples, res);
+		ns_grid += std::chrono::steady_clock::now() - start;
+
+		// a few samples of each satellite against the scalar sgp4
+		for (size_t k = 0; k < samples; k += samples / 8) {
+			sgp4(models[i], state, (double)k, r, v);
+			double rb[3] = { res.x[k], res.y[k], res.z[k] };
+			if (state.error == 0)
+				max_dr = std::max(max_dr, dist3(r, rb));
+		}
+	}
+
+	printf("time grid          : %zu satellites x %zu samples of 1 min\n", sats, samples);
+	printf("  sgp4 loop        : %.1f ns/sample\n", ns_scalar.count() / (double(sats) * samples));
+	printf("  propagate_grid   : %.1f ns/sample, %.2g km from the loop\n", ns_grid.count() / (double(sats) * samples), max_dr);
+}
+
+// the same near earth catalog through the runtime configuration, the dispatcher and
+// the wgs72 / 'i' / 'n' specialization it selects
+static void report_specialized(size_t sats, size_t steps) {
+	std::vector<elsetrec> full = make_catalog(sats);
+	std::vector<sgp4_model> models(sats);
+	for (size_t i = 0; i < sats; i++) {
+		makesgp4model(full[i], models[i]);
+	}
+
+	double r[3], v[3];
+	sgp4_state state{};
+	double check[3] = {};
+	double ns_runtime = time_sweep(sats, steps, [&](size_t i, double t) {
+		sgp4runtime(models[i], state, t, r, v);
+		check[0] += r[0];
+	});
+	double ns_dispatch = time_sweep(sats, steps, [&](size_t i, double t) {
+		sgp4(models[i], state, t, r, v);
+		check[1] += r[0];
+	});
+	double ns_fixed = time_sweep(sats, steps, [&](size_t i, double t) {
+		sgp4fixed<wgs72, 'i', 'n'>(models[i], state, t, r, v);
+		check[2] += r[0];
+	});
+
+	printf("specialized sgp4   : %zu satellites x %zu steps, wgs72 / 'i' / near earth\n", sats, steps);
+	printf("  sgp4runtime      : %.1f ns/prop, %.2f M sat.steps/s\n", ns_runtime, 1e3 / ns_runtime);
+	printf("  sgp4 (dispatch)  : %.1f ns/prop, %.2f M sat.steps/s\n", ns_dispatch, 1e3 / ns_dispatch);
+	printf("  sgp4fixed        : %.1f ns/prop, %.2f M sat.steps/s%s\n", ns_fixed, 1e3 / ns_fixed,
+		check[0] == check[1] && check[0] == check[2] ? "" : "  (results differ!)");
+}
+
+// geosynchronous catalog with epochs spread over a week, every satellite stepped to
+// the same dates computing the sun and moon terms itself or sharing them
+static void report_lunarsolar(size_t sats, size_t steps) {
+	const double pi = 3.14159265358979323846;
+	const double deg2rad = pi / 180.0;
+	const double xpdotp = 1440.0 / (2.0 * pi);
+
+	std::vector<sgp4_model> models(sats);
+	for (size_t i = 0; i < sats; i++) {
+		elsetrec satrec{};
+		double epoch = 20000.5 + (i % 7) + i * 0.001;
+		sgp4init(wgs72, 'i', "00001", epoch, 1e-4, 0.0, 0.0, 0.0003, 90.0 * deg2rad,
+			(0.05 + (i % 13) * 0.3) * deg2rad, fmod(i * 13.1, 360.0) * deg2rad, 1.0027 / xpdotp,
+			fmod(i * 7.3, 360.0) * deg2rad, satrec);
+		satrec.jdsatepoch = 2433281.5 + floor(epoch);
+		satrec.jdsatepochF = epoch - floor(epoch);
+		makesgp4model(satrec, models[i]);
+	}
+	double jd_start = 2433281.5 + 20010.0;
+
+	std::vector<sgp4_state> states(sats);
+	std::vector<double> pos(sats * steps * 3);
+	double max_diff = 0.0;
+
+	auto time_steps = [&](bool shared) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < steps; k++) {
+			double jd = jd_start + k * 10.0 / 1440.0;
+			sgp4_lunarsolar ls;
+			if (shared)
+				lunarsolarterms(jd, ls);
+
+			for (size_t i = 0; i < sats; i++) {
+				const sgp4_model& model = models[i];
+				double tsince = (jd - (model.meta.jdsatepoch + model.meta.jdsatepochF)) * 1440.0;
+				double r[3], v[3];
+				if (shared) {
+					sgp4(model, states[i], tsince, ls, r, v);
+					double* p = &pos[(k * sats + i) * 3];
+					max_diff = std::max(max_diff, std::sqrt((r[0] - p[0]) * (r[0] - p[0]) +
+						(r[1] - p[1]) * (r[1] - p[1]) + (r[2] - p[2]) * (r[2] - p[2])));
+				}
+				else {
+					sgp4(model, states[i], tsince, r, v);
+					std::copy(r, r + 3, &pos[(k * sats + i) * 3]);
+				}
+			}
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / (double(sats) * steps);
+	};
+
+	double ns_own = time_steps(false);
+	double ns_shared = time_steps(true);
+
+	printf("lunar-solar terms  : %zu geosynchronous satellites x %zu steps\n", sats, steps);
+	printf("  per satellite    : %.1f ns/prop\n", ns_own);
+	printf("  shared per date  : %.1f ns/prop, max difference %.2g km\n", ns_shared, max_diff);
+}
+
+// look angles of a catalog snapshot from one observer : the full evaluation from the
+// date, from a shared sidereal angle, and the elevation sine alone
+static void report_look_angles(size_t sats) {
+	std::vector<elsetrec> catalog = make_catalog(sats);
+	std::vector<eci_pos_t> pos(sats);
+	for (size_t i = 0; i < sats; i++) {
+		double r[3], v[3];
+		sgp4(catalog[i], 100.0, r, v);
+		pos[i].set(r, v);
+	}
+
+	observer_t observer;
+	observer.update(2451545.0, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+	double jd = catalog[0].jdsatepoch + catalog[0].jdsatepochF + 100.0 / 1440.0;
+
+	double check[3] = {};
+	auto time_all = [&](auto look) {
+		const size_t reps = 20;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < reps; k++) {
+			for (size_t i = 0; i < sats; i++) {
+				look(i);
+			}
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / (double(sats) * reps);
+	};
+
+	double ns_jd = time_all([&](size_t i) {
+		check[0] += observer.get_lookup_angle(jd, pos[i]).elevation;
+	});
+	sidereal_t st = observer.sidereal(jd);
+	double ns_st = time_all([&](size_t i) {
+		check[1] += observer.get_lookup_angle(st, pos[i]).elevation;
+	});
+	double ns_sin = time_all([&](size_t i) {
+		check[2] += observer.sin_elevation(st, pos[i].pos);
+	});
+
+	size_t sign_mismatch = 0;
+	for (size_t i = 0; i < sats; i++) {
+		bool above = observer.sin_elevation(st, pos[i].pos) > 0.0;
+		sign_mismatch += above != (observer.get_lookup_angle(st, pos[i]).elevation > 0.0) ? 1 : 0;
+	}
+
+	printf("look angles        : %zu satellites, one observer\n", sats);
+	printf("  from the date    : %.1f ns/sat\n", ns_jd);
+	printf("  shared sidereal  : %.1f ns/sat%s\n", ns_st, check[0] == check[1] ? "" : "  (results differ!)");
+	printf("  sin_elevation    : %.1f ns/sat%s\n", ns_sin, sign_mismatch == 0 ? "" : "  (signs differ!)");
+}
+
+// look angles of a catalog snapshot from several sites, one observer_t per site
+// against observer_set_t : all the angles, then only the angles of the satellites
+// above the horizon as a tracker needs them, and the view without the angles
+static void report_observers(size_t sats, size_t sites) {
+	std::vector<elsetrec> catalog = make_catalog(sats);
+	std::vector<eci_pos_t> pos(sats);
+	for (size_t i = 0; i < sats; i++) {
+		double r[3], v[3];
+		sgp4(catalog[i], 100.0, r, v);
+		pos[i].set(r, v);
+	}
+	double jd = catalog[0].jdsatepoch + catalog[0].jdsatepochF + 100.0 / 1440.0;
+
+	std::vector<observer_t> observers(sites);
+	observer_set_t set;
+	for (size_t j = 0; j < sites; j++) {
+		geodetic_t g{ to_rad(-60.0 + 120.0 * j / sites), to_rad(-180.0 + 360.0 * j / sites), 0.001 * j };
+		observers[j].update(jd, g);
+		set.add(g);
+	}
+	std::vector<sidereal_t> st(sites);
+	for (size_t j = 0; j < sites; j++) {
+		st[j] = observers[j].sidereal(jd);
+	}
+	double theta = to_gmst(jd);
+	sidereal_t gst{ theta, std::sin(theta), std::cos(theta) };
+
+	// best of a few runs, the loops are short
+	auto time_ns = [&](auto body) {
+		double best = 0.0;
+		for (int run = 0; run < 5; run++) {
+			auto start = std::chrono::steady_clock::now();
+			body();
+			std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+		}
+		return best / double(sats * sites);
+	};
+
+	// all the angles
+	std::vector<topocentric_t> single(sats * sites), shared(sats * sites);
+	double ns_single = time_ns([&] {
+		for (size_t i = 0; i < sats; i++) {
+			for (size_t j = 0; j < sites; j++) {
+				single[i * sites + j] = observers[j].get_lookup_angle(st[j], pos[i]);
+			}
+		}
+	});
+	observer_view_t view;
+	double ns_shared = time_ns([&] {
+		for (size_t i = 0; i < sats; i++) {
+			set.get_lookup_angles(gst, pos[i], view, &shared[i * sites]);
+		}
+	});
+
+	// angles of the visible satellites only
+	size_t visible_single = 0, visible_shared = 0;
+	double check_single = 0.0, check_shared = 0.0;
+	double ns_vis_single = time_ns([&] {
+		visible_single = 0;
+		check_single = 0.0;
+		for (size_t i = 0; i < sats; i++) {
+			for (size_t j = 0; j < sites; j++) {
+				if (observers[j].sin_elevation(st[j], pos[i].pos) > 0.0) {
+					check_single += observers[j].get_lookup_angle(st[j], pos[i]).azimuth;
+					visible_single++;
+				}
+			}
+		}
+	});
+	double ns_vis_shared = time_ns([&] {
+		visible_shared = 0;
+		check_shared = 0.0;
+		for (size_t i = 0; i < sats; i++) {
+			set.observe(gst, pos[i], view);
+			for (size_t j = 0; j < sites; j++) {
+				if (view.sin_el[j] > 0.0) {
+					check_shared += set.look_angle(view, j).azimuth;
+					visible_shared++;
+				}
+			}
+		}
+	});
+
+	// range rate and elevation sine, as a doppler correction needs them : observer_t
+	// only has them through get_lookup_angle, the first loop
+	double max_view = 0.0;
+	std::vector<double> rates(sats * sites), sines(sats * sites);
+	double ns_view = time_ns([&] {
+		for (size_t i = 0; i < sats; i++) {
+			set.observe(gst, pos[i], view);
+			std::copy(view.range_rate.begin(), view.range_rate.end(), &rates[i * sites]);
+			std::copy(view.sin_el.begin(), view.sin_el.end(), &sines[i * sites]);
+		}
+	});
+	for (size_t k = 0; k < sats * sites; k++) {
+		max_view = std::max(max_view, std::fabs(rates[k] - single[k].range_rate) + std::fabs(sines[k] - std::sin(single[k].elevation)));
+	}
+
+	double max_az = 0.0, max_el = 0.0, max_range = 0.0, max_rate = 0.0;
+	for (size_t k = 0; k < sats * sites; k++) {
+		double daz = std::fabs(shared[k].azimuth - single[k].azimuth);
+		max_az = std::max(max_az, std::min(daz, 2.0 * M_PI - daz));
+		max_el = std::max(max_el, std::fabs(shared[k].elevation - single[k].elevation));
+		max_range = std::max(max_range, std::fabs(shared[k].range - single[k].range));
+		max_rate = std::max(max_rate, std::fabs(shared[k].range_rate - single[k].range_rate));
+	}
+
+	printf("observer sets      : %zu satellites, %zu sites, %.1f%% visible\n", sats, sites, 100.0 * visible_single / double(sats * sites));
+	printf("  all angles       : observer_t %.1f ns/sat/site, observer_set_t %.1f ns/sat/site\n", ns_single, ns_shared);
+	printf("  visible angles   : observer_t %.1f ns/sat/site, observer_set_t %.1f ns/sat/site%s\n", ns_vis_single, ns_vis_shared,
+		visible_single == visible_shared && std::fabs(check_single - check_shared) < 1e-6 ? "" : "  (results differ!)");
+	printf("  no angle         : observer_t %.1f ns/sat/site, observer_set_t %.1f ns/sat/site for range, range rate and elevation sine%s\n",
+		ns_single, ns_view, max_view < 1e-9 ? "" : "  (results differ!)");
+	printf("  max difference   : %.2g rad az, %.2g rad el, %.2g km, %.2g km/s\n", max_az, max_el, max_range, max_rate);
+}
+
+// julian_formatter_t against julian_to_string : random dates of the next years,
+// and dates on or next to whole seconds where the truncation of the seconds matters
+static void report_timestamps(size_t count) {
+	std::mt19937 gen(3);
+	std::uniform_real_distribution<double> dist(2451545.0, 2451545.0 + 50 * 365.25);
+	std::vector<double> dates;
+	for (size_t k = 0; k < count / 2; k++) {
+		dates.push_back(dist(gen));
+	}
+	for (size_t k = 0; dates.size() < count; k++) {
+		double jd = std::floor(dist(gen)) + 0.5 + (double)(gen() % 86400) / 86400.0;
+		dates.push_back(k % 3 == 0 ? jd : std::nextafter(jd, k % 3 == 1 ? 0.0 : 1e9));
+	}
+
+	for (bool utc : { true, false }) {
+		julian_formatter_t formatter(utc);
+
+		size_t mismatch = 0, bytes = 0;
+		for (double jd : dates) {
+			mismatch += formatter.to_string(jd) != julian_to_string(jd, utc) ? 1 : 0;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (double jd : dates) {
+			bytes += julian_to_string(jd, utc).size();
+		}
+		std::chrono::duration<double, std::nano> ns_string = std::chrono::steady_clock::now() - start;
+
+		char buf[julian_formatter_t::max_length];
+		start = std::chrono::steady_clock::now();
+		for (double jd : dates) {
+			bytes += formatter.format(jd, buf);
+		}
+		std::chrono::duration<double, std::nano> ns_format = std::chrono::steady_clock::now() - start;
+
+		printf("timestamps %-5s   : %zu dates, julian_to_string %.0f ns, julian_formatter_t %.0f ns, %zu mismatch%s\n",
+			utc ? "utc" : "local", dates.size(), ns_string.count() / dates.size(), ns_format.count() / dates.size(),
+			mismatch, bytes == 0 ? "!" : "");
+	}
+}
+
+// resolution of the system clock date, and a frozen clock stepped by hand
+static void report_clock() {
+	double smallest = 1.0;
+	double previous = julian_now();
+	for (int k = 0; k < 100000; k++) {
+		double jd = julian_now();
+		if (jd != previous)
+			smallest = std::min(smallest, jd - previous);
+		previous = jd;
+	}
+
+	sat_clock_t clock;
+	clock.set_scale(0.0);
+	clock.set_date(2460000.5);
+	double frozen = clock.now();
+	clock.advance(1.0 / 1440.0);
+	bool deterministic = frozen == 2460000.5 && clock.now() == 2460000.5 + 1.0 / 1440.0;
+
+	printf("clock              : smallest step %.1f us, frozen clock %s\n", smallest * 86400e6, deterministic ? "ok" : "not deterministic!");
+}
+
+// sidereal angles of a 30 days grid at 10 s, direct formula against the stepped grid
+static void report_sidereal() {
+	const double jd_start = 2460000.3;
+	const double jd_step = 10.0 / 86400.0;
+	const size_t steps = 30 * 8640;
+	const double lon = to_rad(2.35);
+
+	std::vector<sidereal_t> direct(steps);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t k = 0; k < steps; k++) {
+		double theta = to_lmst(jd_start + (double)k * jd_step, lon);
+		direct[k] = sidereal_t{ theta, std::sin(theta), std::cos(theta) };
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	printf("sidereal grid      : %zu steps of 10 s\n", steps);
+	printf("  to_lmst, sin, cos: %.1f ns/step\n", elapsed.count() / steps);
+
+	for (int reanchor : { 16, sidereal_grid_t::default_reanchor, 1024, 1 << 30 }) {
+		double max_err = 0.0;
+		start = std::chrono::steady_clock::now();
+		sidereal_grid_t grid(jd_start, jd_step, lon, reanchor);
+		for (size_t k = 0; k < steps; k++) {
+			grid.next();
+		}
+		elapsed = std::chrono::steady_clock::now() - start;
+
+		sidereal_grid_t grid2(jd_start, jd_step, lon, reanchor);
+		for (size_t k = 0; k < steps; k++) {
+			const sidereal_t& st = grid2.current();
+			max_err = std::max(max_err, std::fabs(st.sin_theta * direct[k].cos_theta - st.cos_theta * direct[k].sin_theta));
+			grid2.next();
+		}
+
+		printf("  reanchor %-8s: %.1f ns/step, max error %.2g rad, reported drift %.2g rad\n",
+			reanchor == 1 << 30 ? "never" : std::to_string(reanchor).c_str(), elapsed.count() / steps,
+			max_err, grid2.max_drift());
+	}
+}
+
+// satellites of the bundled tle files, empty when the program does not run from
+// the repository root
+static void load_bundled(sat_catalog_t& catalog) {
+	std::vector<std::string> files;
+	std::error_code ec;
+	for (auto& entry : std::filesystem::directory_iterator("data/tle", ec)) {
+		if (entry.path().extension() == ".txt")
+			files.push_back(entry.path().string());
+	}
+
+	catalog.load(files, bench_pool());
+}
+
+// closed form geodetic conversion against the iterative one, one revolution of
+// every satellite of the bundled tle files (run from the repository root)
+static void report_geodetic(size_t steps) {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("geodetic           : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<double> x, y, z, gmst, jd;
+	for (const sgp4_model& model : catalog.models()) {
+		sgp4_state state{};
+		double period = 2.0 * M_PI / model.meta.no_kozai;
+		for (size_t k = 0; k < steps; k++) {
+			double tsince = period * (double)k / (double)steps;
+			double r[3], v[3];
+			if (!sgp4(model, state, tsince, r, v))
+				break;
+
+			x.push_back(r[0]);
+			y.push_back(r[1]);
+			z.push_back(r[2]);
+			jd.push_back(epoch_jd(model) + tsince / 1440.0);
+			gmst.push_back(to_gmst(jd.back()));
+		}
+	}
+	const size_t n = x.size();
+
+	std::vector<geodetic_t> iterative(n);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t k = 0; k < n; k++) {
+		eci_pos_t pv{ vector_t{ x[k], y[k], z[k] }, vector_t{} };
+		iterative[k].update_iterative(jd[k], pv);
+	}
+	std::chrono::duration<double, std::nano> ns_iterative = std::chrono::steady_clock::now() - start;
+
+	std::vector<geodetic_t> closed(n);
+	start = std::chrono::steady_clock::now();
+	for (size_t k = 0; k < n; k++) {
+		eci_pos_t pv{ vector_t{ x[k], y[k], z[k] }, vector_t{} };
+		closed[k].update(sidereal_t{ gmst[k], 0.0, 0.0 }, pv);
+	}
+	std::chrono::duration<double, std::nano> ns_closed = std::chrono::steady_clock::now() - start;
+
+	geodetic_soa_t batch;
+	start = std::chrono::steady_clock::now();
+	to_geodetic(x.data(), y.data(), z.data(), gmst.data(), n, batch);
+	std::chrono::duration<double, std::nano> ns_batch = std::chrono::steady_clock::now() - start;
+
+	double alt_min = 1e30, alt_max = -1e30, max_lat = 0.0, max_lon = 0.0, max_alt = 0.0;
+	size_t batch_mismatch = 0;
+	for (size_t k = 0; k < n; k++) {
+		alt_min = std::min(alt_min, iterative[k].alt);
+		alt_max = std::max(alt_max, iterative[k].alt);
+		max_lat = std::max(max_lat, std::fabs(closed[k].lat - iterative[k].lat));
+		max_lon = std::max(max_lon, std::fabs(closed[k].lon - iterative[k].lon));
+		max_alt = std::max(max_alt, std::fabs(closed[k].alt - iterative[k].alt));
+		batch_mismatch += (batch.lat[k] != closed[k].lat || batch.lon[k] != closed[k].lon || batch.alt[k] != closed[k].alt) ? 1 : 0;
+	}
+
+	printf("geodetic           : %zu satellites of data/tle, %zu positions, altitude %.0f to %.0f km\n",
+		catalog.size(), n, alt_min, alt_max);
+	printf("  iterative        : %.1f ns/position\n", ns_iterative.count() / n);
+	printf("  closed form      : %.1f ns/position, max difference %.2g rad lat, %.2g rad lon, %.2g km alt\n",
+		ns_closed.count() / n, max_lat, max_lon, max_alt);
+	printf("  batch            : %.1f ns/position%s\n", ns_batch.count() / n, batch_mismatch == 0 ? "" : "  (results differ!)");
+}
+
+// one day of Chebyshev ephemeris of every bundled satellite, as the widget fits it,
+// against sgp4 at random times : samples above the error estimate of their segment
+static void report_ephemeris(size_t samples) {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("ephemeris          : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<double> epochs;
+	for (const sgp4_model& model : catalog.models()) {
+		epochs.push_back(epoch_jd(model));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+	double jd_end = jd_start + 1.0;
+	const double tolerance = 0.001;
+
+	std::mt19937 gen(5);
+	std::uniform_real_distribution<double> dist(jd_start, jd_end);
+
+	size_t built = 0, segments = 0, above_tolerance = 0, count = 0, above_estimate = 0, above_tol_samples = 0;
+	double max_ratio = 0.0, max_err = 0.0, ms_build = 0.0, ns_ephem = 0.0, ns_sgp4 = 0.0;
+	std::vector<double> jds(samples);
+	std::vector<eci_pos_t> fitted(samples);
+	for (const sgp4_model& model : catalog.models()) {
+		sat_ephemeris_t ephem;
+		auto start = std::chrono::steady_clock::now();
+		bool ok = ephem.build(model, jd_start, jd_end, tolerance);
+		ms_build += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (!ok)
+			continue;
+
+		built++;
+		segments += ephem.segments().size();
+		above_tolerance += ephem.above_tolerance();
+
+		for (auto& jd : jds) {
+			jd = dist(gen);
+		}
+
+		start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < samples; k++) {
+			ephem.get_pos(jds[k], fitted[k]);
+		}
+		ns_ephem += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		sgp4_state state{};
+		start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < samples; k++) {
+			double r[3], v[3];
+			sgp4(model, state, (jds[k] - epoch_jd(model)) * 1440.0, r, v);
+			fitted[k].pos = fitted[k].pos - vector_t{ r[0], r[1], r[2] };
+		}
+		ns_sgp4 += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		for (size_t k = 0; k < samples; k++) {
+			// get_pos refused these, the caller falls back to sgp4
+			const sat_ephemeris_t::segment_t* seg = ephem.segment(jds[k]);
+			if (!seg->within_tolerance)
+				continue;
+
+			double err = fitted[k].pos.mag();
+			count++;
+			max_err = std::max(max_err, err);
+			max_ratio = std::max(max_ratio, err / seg->max_error_km);
+			above_estimate += err > seg->max_error_km ? 1 : 0;
+			above_tol_samples += err > tolerance ? 1 : 0;
+		}
+	}
+
+	printf("ephemeris          : %zu of %zu satellites fitted over 1 day, tolerance %.0f m, order %d\n",
+		built, catalog.size(), tolerance * 1e3, sat_ephemeris_t::default_order);
+	printf("  fit              : %.2f ms/satellite, %zu segments, %zu above the tolerance\n",
+		ms_build / catalog.size(), segments, above_tolerance);
+	printf("  get_pos          : %.1f ns, sgp4 %.1f ns\n", ns_ephem / count, ns_sgp4 / count);
+	printf("  random times     : %zu samples, %zu above the segment estimate, at most %.2f times it, %zu above the tolerance, max %.2g km\n",
+		count, above_estimate, max_ratio, above_tol_samples, max_err);
+}
+
+// one day of passes of every bundled satellite over Paris, one satellite after the
+// other and with pass_predictor_t, then a run canceled right after its start
+static void report_predictions() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("predictions        : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<const sgp4_model*> models;
+	std::vector<double> epochs;
+	for (const sgp4_model& model : catalog.models()) {
+		models.push_back(&model);
+		epochs.push_back(epoch_jd(model));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+	double jd_end = jd_start + 1.0;
+
+	observer_t observer;
+	observer.update(jd_start, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::vector<pass_t>> serial;
+	size_t passes = 0;
+	for (const sgp4_model* model : models) {
+		serial.push_back(find_passes(*model, observer, jd_start, jd_end));
+		passes += serial.back().size();
+	}
+	std::chrono::duration<double, std::milli> ms_serial = std::chrono::steady_clock::now() - start;
+
+	printf("predictions        : %zu satellites, 1 day, %zu passes\n", models.size(), passes);
+	printf("  one by one       : %.1f ms\n", ms_serial.count());
+
+	// 1, 2, 4... threads up to the hardware threads : the wall time should follow 1/threads
+	std::vector<size_t> counts;
+	for (size_t n = 1; n < bench_pool().size(); n *= 2) {
+		counts.push_back(n);
+	}
+	counts.push_back(bench_pool().size());
+
+	for (size_t threads : counts) {
+		thread_pool_t pool(threads);
+		pass_predictor_t predictor(pool);
+
+		std::atomic<size_t> callbacks{};
+		start = std::chrono::steady_clock::now();
+		predictor.start(models, observer, jd_start, jd_end, 0.0, [&](size_t, size_t, size_t) {
+			callbacks++;
+		});
+		predictor.wait();
+		std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+
+		size_t mismatch = 0;
+		for (size_t i = 0; i < models.size(); i++) {
+			std::span<const pass_record_t> p = predictor.passes(i);
+			mismatch += (p.size() != serial[i].size() || !std::equal(p.begin(), p.end(), serial[i].begin(),
+				[](const pass_record_t& a, const pass_t& b) { return a.pass.jd_start == b.jd_start && a.pass.jd_end == b.jd_end; })) ? 1 : 0;
+		}
+
+		printf("  pass_predictor_t : %.1f ms, %zu threads, %.2f of one by one, %zu progress calls, %zu satellites differ\n",
+			ms.count(), pool.size(), ms.count() / ms_serial.count(), callbacks.load(), mismatch);
+	}
+
+	// 7 days streamed through a queue drained every ms, as the predictions dialog does
+	{
+		struct found_t {
+			size_t sat;
+			pass_t pass;
+		};
+		mpsc_queue_t<found_t> queue;
+		std::vector<found_t> drained;
+		pass_predictor_t predictor(bench_pool());
+
+		start = std::chrono::steady_clock::now();
+		predictor.start(models, observer, jd_start, jd_start + 7.0, 0.0, {}, [&](size_t sat, const pass_t& pass) {
+			queue.push(found_t{ sat, pass });
+		});
+
+		double ms_first = -1.0;
+		while (true) {
+			bool running = predictor.running();
+			if (queue.pop_all(drained) > 0 && ms_first < 0.0)
+				ms_first = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (!running)
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::chrono::duration<double, std::milli> ms_all = std::chrono::steady_clock::now() - start;
+
+		size_t total = 0;
+		for (size_t i = 0; i < models.size(); i++) {
+			total += predictor.passes(i).size();
+		}
+		printf("  streamed 7 days  : first pass drained after %.2f ms, %zu of %zu passes after %.1f ms\n",
+			ms_first, drained.size(), total, ms_all.count());
+	}
+
+	pass_predictor_t predictor(bench_pool());
+	predictor.start(models, observer, jd_start, jd_start + 30.0);
+	start = std::chrono::steady_clock::now();
+	predictor.cancel();
+	predictor.wait();
+	std::chrono::duration<double, std::milli> ms_cancel = std::chrono::steady_clock::now() - start;
+	printf("  canceled 30 days : stopped in %.2f ms, %zu of %zu satellites done\n", ms_cancel.count(), predictor.done(), models.size());
+}
+
+// passes of 7 days of 200 satellites put in date order : the former multiset of named
+// passes filled from one vector per satellite, against the records of pass_predictor_t
+// merged by merge_passes
+static void report_merge() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("merge              : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<const sgp4_model*> models;
+	std::vector<double> epochs;
+	for (size_t i = 0; i < catalog.size() && i < 200; i++) {
+		models.push_back(&catalog.model(i));
+		epochs.push_back(epoch_jd(catalog.model(i)));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+	double jd_end = jd_start + 7.0;
+
+	observer_t observer;
+	observer.update(jd_start, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+
+	struct named_pass_t {
+		pass_t pass;
+		std::string name;
+
+		bool operator<(const named_pass_t& rhs) const {
+			return pass.jd_start < rhs.pass.jd_start;
+		}
+	};
+
+	size_t before = allocations.load();
+	std::vector<std::vector<pass_t>> per_sat;
+	for (const sgp4_model* model : models) {
+		per_sat.push_back(find_passes(*model, observer, jd_start, jd_end));
+	}
+	size_t alloc_scan = allocations.load() - before;
+
+	before = allocations.load();
+	auto start = std::chrono::steady_clock::now();
+	std::multiset<named_pass_t> sorted;
+	for (size_t i = 0; i < models.size(); i++) {
+		for (const pass_t& pass : per_sat[i]) {
+			sorted.insert(named_pass_t{ pass, catalog.name(i) });
+		}
+	}
+	std::chrono::duration<double, std::milli> ms_set = std::chrono::steady_clock::now() - start;
+	size_t alloc_set = allocations.load() - before;
+
+	pass_predictor_t predictor(bench_pool());
+	before = allocations.load();
+	predictor.start(models, observer, jd_start, jd_end);
+	predictor.wait();
+	size_t alloc_run = allocations.load() - before;
+
+	std::vector<pass_record_t> merged;
+	before = allocations.load();
+	start = std::chrono::steady_clock::now();
+	predictor.merge(merged);
+	std::chrono::duration<double, std::milli> ms_merge = std::chrono::steady_clock::now() - start;
+	size_t alloc_merge = allocations.load() - before;
+
+	// same dates in the same order, the satellites of equal dates may differ
+	bool same = merged.size() == sorted.size() && std::equal(merged.begin(), merged.end(), sorted.begin(),
+		[](const pass_record_t& a, const named_pass_t& b) { return a.pass.jd_start == b.pass.jd_start; });
+
+	printf("merge              : %zu satellites, 7 days, %zu passes, %zu bytes per record\n", models.size(), merged.size(), sizeof(pass_record_t));
+	printf("  multiset         : scan %zu allocations, insert %.2f ms and %zu allocations\n", alloc_scan, ms_set.count(), alloc_set);
+	printf("  records + merge  : scan %zu allocations, merge %.2f ms and %zu allocations, %s order\n", alloc_run, ms_merge.count(), alloc_merge,
+		same ? "same" : "different");
+}
+
+// next passes of the bundled satellites from pass_generator_t, against one day of passes
+// of all of them merged : same passes, and the propagations each of them cost
+static void report_generator() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("generator          : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<const sgp4_model*> models;
+	std::vector<double> epochs;
+	for (const sgp4_model& model : catalog.models()) {
+		models.push_back(&model);
+		epochs.push_back(epoch_jd(model));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+	double jd_end = jd_start + 1.0;
+
+	observer_t observer;
+	observer.update(jd_start, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+
+	pass_scan_stats_t full_stats;
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::vector<pass_record_t>> per_sat(models.size());
+	for (size_t i = 0; i < models.size(); i++) {
+		for (const pass_t& pass : find_passes(*models[i], observer, jd_start, jd_end, {}, &full_stats)) {
+			per_sat[i].push_back(pass_record_t{ pass, (uint32_t)i });
+		}
+	}
+	std::vector<std::span<const pass_record_t>> runs(per_sat.begin(), per_sat.end());
+	std::vector<pass_record_t> all;
+	merge_passes(runs, all);
+	std::chrono::duration<double, std::milli> ms_full = std::chrono::steady_clock::now() - start;
+
+	printf("generator          : %zu satellites, 1 day, %zu passes\n", models.size(), all.size());
+	printf("  whole day        : %.1f ms, %zu propagations\n", ms_full.count(), full_stats.samples);
+
+	for (size_t count : { (size_t)1, (size_t)10, (size_t)100, all.size() }) {
+		start = std::chrono::steady_clock::now();
+		pass_generator_t generator(models, observer, jd_start, jd_end);
+		std::vector<pass_record_t> next;
+		pass_record_t r;
+		while (next.size() < count && generator.next(r)) {
+			next.push_back(r);
+		}
+		std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+
+		size_t differ = 0;
+		for (size_t i = 0; i < next.size(); i++) {
+			differ += (i >= all.size() || next[i].pass.jd_start != all[i].pass.jd_start || next[i].pass.jd_end != all[i].pass.jd_end) ? 1 : 0;
+		}
+		printf("  next %-5zu       : %.2f ms, %zu propagations, %zu passes, %zu differ\n", count, ms.count(),
+			generator.stats().samples, next.size(), differ);
+	}
+}
+
+// predictions of the dialog through cache : the cached passes of each satellite, then
+// a scan of the rest of the window. hashes : elements of the satellites. Returns the
+// days scanned, out : passes of each satellite
+static double predict_cached(pass_cache_t& cache, const sat_catalog_t& catalog, const std::vector<uint64_t>& hashes,
+	const observer_t& observer, double jd_start, double jd_end, std::vector<std::vector<pass_t>>& out) {
+	out.assign(catalog.size(), {});
+
+	std::vector<size_t> scanned;
+	std::vector<pass_cache_t::key_t> keys;
+	std::vector<const sgp4_model*> models;
+	std::vector<double> starts;
+	double days = 0.0;
+	for (size_t i = 0; i < catalog.size(); i++) {
+		pass_cache_t::key_t key{ hashes[i], observer.geo.lat, observer.geo.lon, observer.geo.alt, 0.0 };
+		cache.passes(key, jd_start, jd_end, out[i]);
+
+		double from = cache.scan_from(key, jd_start, jd_end);
+		if (from >= jd_end)
+			continue;
+
+		scanned.push_back(i);
+		keys.push_back(key);
+		models.push_back(&catalog.model(i));
+		starts.push_back(from);
+		days += jd_end - from;
+	}
+	if (models.empty())
+		return 0.0;
+
+	pass_predictor_t predictor(bench_pool());
+	predictor.start(models, starts, observer, jd_end);
+	predictor.wait();
+
+	std::vector<pass_t> passes;
+	for (size_t k = 0; k < scanned.size(); k++) {
+		size_t i = scanned[k];
+		double cached = out[i].empty() ? 0.0 : out[i].back().jd_start + 1.0 / 86400.0;
+
+		passes.clear();
+		for (const pass_record_t& record : predictor.passes(k)) {
+			passes.push_back(record.pass);
+			if (record.pass.jd_start > cached)
+				out[i].push_back(record.pass);
+		}
+		cache.store(keys[k], catalog.name(i), jd_start, starts[k], jd_end, predictor.known(k), passes);
+	}
+
+	return days;
+}
+
+// the dialog opened again with a pass_cache_t : unchanged inputs, the cache read back
+// from a file, the window moved forward and new elements for some satellites. The
+// passes are checked against a scan of the whole window
+static void report_cache() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("pass cache         : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<uint64_t> hashes;
+	std::vector<double> epochs;
+	for (size_t i = 0; i < catalog.size(); i++) {
+		hashes.push_back(catalog.hash(i));
+		epochs.push_back(epoch_jd(catalog.model(i)));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+
+	observer_t observer;
+	observer.update(jd_start, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+
+	// against a scan of the whole window : satellites with other passes, and the largest
+	// difference of the dates of the same passes (s). The crossings of a scan started
+	// elsewhere are refined from other brackets, a few ms apart
+	struct check_t {
+		size_t differ;
+		double max_error;
+	};
+	auto check = [&](double from, double to, const std::vector<std::vector<pass_t>>& out) {
+		check_t c{};
+		for (size_t i = 0; i < catalog.size(); i++) {
+			std::vector<pass_t> fresh = find_passes(catalog.model(i), observer, from, to);
+			if (fresh.size() != out[i].size()) {
+				c.differ++;
+				continue;
+			}
+
+			for (size_t k = 0; k < fresh.size(); k++) {
+				c.max_error = std::max({ c.max_error, std::abs(fresh[k].jd_start - out[i][k].jd_start), std::abs(fresh[k].jd_end - out[i][k].jd_end) });
+			}
+		}
+		c.max_error *= 86400.0;
+		return c;
+	};
+
+	pass_cache_t cache;
+	std::vector<std::vector<pass_t>> out;
+	auto run = [&](const char* label, double from, double to) {
+		auto start = std::chrono::steady_clock::now();
+		double days = predict_cached(cache, catalog, hashes, observer, from, to, out);
+		std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+
+		size_t passes = 0;
+		for (auto& p : out) {
+			passes += p.size();
+		}
+		check_t c = check(from, to, out);
+		printf("  %-16s : %.2f ms, %.1f satellite days scanned, %zu passes, %zu satellites differ, dates within %.3f s\n", label,
+			ms.count(), days, passes, c.differ, c.max_error);
+	};
+
+	printf("pass cache         : %zu satellites, 1 day\n", catalog.size());
+	run("cold", jd_start, jd_start + 1.0);
+	run("warm", jd_start, jd_start + 1.0);
+
+	std::string filename = (std::filesystem::temp_directory_path() / "sat_bench_passes.bin").string();
+	bool saved = cache.save(filename);
+	size_t entries = cache.size();
+	cache.clear();
+	bool loaded = cache.load(filename);
+	std::filesystem::remove(filename);
+	printf("  file             : %s, %zu of %zu entries read back\n", saved && loaded ? "saved and loaded" : "failed", cache.size(), entries);
+	run("from file", jd_start, jd_start + 1.0);
+
+	run("1 h later", jd_start + 1.0 / 24.0, jd_start + 1.0 + 1.0 / 24.0);
+	run("1 day later", jd_start + 1.0, jd_start + 2.0);
+
+	// new elements for one satellite in 10, same orbits : only they are scanned again
+	for (size_t i = 0; i < hashes.size(); i += 10) {
+		hashes[i] ^= 1;
+	}
+	run("new elements", jd_start + 1.0, jd_start + 2.0);
+	printf("  entries          : %zu for %zu satellites\n", cache.size(), catalog.size());
+}
+
+// fixed step and adaptive scans over 3 days of the bundled satellites, the passes
+// of a fixed step scan at 400 samples per period are the reference
+static void report_pass_scan() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("pass scan          : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<double> epochs;
+	for (const sgp4_model& model : catalog.models()) {
+		epochs.push_back(epoch_jd(model));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+	double jd_end = jd_start + 3.0;
+
+	observer_t observer;
+	observer.update(jd_start, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+
+	using scan_fn = std::function<std::vector<pass_t>(const sgp4_model&, pass_scan_stats_t&)>;
+	auto run = [&](const scan_fn& scan, std::vector<std::vector<pass_t>>& passes, pass_scan_stats_t& stats) {
+		passes.clear();
+		auto start = std::chrono::steady_clock::now();
+		for (const sgp4_model& model : catalog.models()) {
+			passes.push_back(scan(model, stats));
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	};
+
+	std::vector<std::vector<pass_t>> reference;
+	pass_scan_stats_t ref_stats;
+	run([&](const sgp4_model& model, pass_scan_stats_t& stats) {
+		return find_passes_fixed_step(model, observer, jd_start, jd_end, 400, &stats);
+	}, reference, ref_stats);
+
+	size_t ref_count = 0;
+	double shortest = 1.0;
+	for (auto& p : reference) {
+		ref_count += p.size();
+		for (auto& pass : p) {
+			shortest = std::min(shortest, pass.jd_end - pass.jd_start);
+		}
+	}
+	printf("pass scan          : %zu satellites, 3 days, %zu reference passes, shortest %.0f s\n",
+		catalog.size(), ref_count, shortest * 86400.0);
+
+	// passes of the reference no pass overlaps, and largest aos difference of the others
+	auto missed = [&](const std::vector<std::vector<pass_t>>& passes, double& longest, double& aos_error) {
+		size_t count = 0;
+		longest = 0.0;
+		aos_error = 0.0;
+		for (size_t i = 0; i < reference.size(); i++) {
+			for (auto& ref : reference[i]) {
+				auto it = std::find_if(passes[i].begin(), passes[i].end(), [&](const pass_t& p) {
+					return p.jd_start < ref.jd_end && ref.jd_start < p.jd_end;
+				});
+				if (it == passes[i].end()) {
+					count++;
+					longest = std::max(longest, ref.jd_end - ref.jd_start);
+				}
+				else
+					aos_error = std::max(aos_error, std::fabs(it->jd_start - ref.jd_start));
+			}
+		}
+		return count;
+	};
+
+	for (int adaptive = 0; adaptive < 2; adaptive++) {
+		std::vector<std::vector<pass_t>> passes;
+		pass_scan_stats_t stats;
+		double ms = run([&](const sgp4_model& model, pass_scan_stats_t& stats) {
+			return adaptive ? find_passes(model, observer, jd_start, jd_end, {}, &stats)
+				: find_passes_fixed_step(model, observer, jd_start, jd_end, 20, &stats);
+		}, passes, stats);
+
+		size_t count = 0;
+		for (auto& p : passes) {
+			count += p.size();
+		}
+		double longest, aos_error;
+		size_t miss = missed(passes, longest, aos_error);
+
+		printf("  %-16s : %.1f ms, %zu samples, %zu passes, %zu missed (longest %.0f s), aos off by %.1f s at most\n",
+			adaptive ? "adaptive" : "fixed 1/20 rev", ms, stats.samples, count, miss, longest * 86400.0, aos_error * 86400.0);
+		printf("  %-16s   %zu crossings refined with %.1f propagations each\n", "", stats.crossings,
+			stats.crossings ? (double)stats.evaluations / stats.crossings : 0.0);
+	}
+}
+
+// crossings of the passes of one day of the bundled satellites, in brackets as wide as
+// the scan steps (1/20 of the period) : regula_falsi against find_crossing, both against
+// a bisection down to the resolution of the date. Then the crossings of 10 deg with find_crossing
+static void report_crossings() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("crossings          : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<double> epochs;
+	for (const sgp4_model& model : catalog.models()) {
+		epochs.push_back(epoch_jd(model));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+
+	observer_t observer;
+	observer.update(jd_start, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+
+	struct bracket_t {
+		const sgp4_model* model;
+		double jd_a, jd_b;
+	};
+	std::vector<bracket_t> brackets;
+	std::mt19937 gen(5);
+	std::uniform_real_distribution<double> dist(0.0, 1.0);
+	for (const sgp4_model& model : catalog.models()) {
+		double step = 2.0 * M_PI / model.meta.no_kozai / 1440.0 / 20.0;
+		for (const pass_t& pass : find_passes(model, observer, jd_start, jd_start + 1.0)) {
+			for (double jd : { pass.jd_start, pass.jd_end }) {
+				double u = dist(gen);
+				bracket_t b{ &model, jd - u * step, jd + (1.0 - u) * step };
+
+				// one crossing per bracket : passes shorter than a step are left out
+				if (b.jd_a < pass.jd_start && pass.jd_end < b.jd_b)
+					continue;
+				brackets.push_back(b);
+			}
+		}
+	}
+
+	// crossing of threshold in [a, b], by bisection
+	auto bisect = [&](const bracket_t& b, double threshold) {
+		elevation_eval_t eval(*b.model, observer);
+		double target = std::sin(threshold);
+		double a = b.jd_a, c = b.jd_b;
+		double fa = eval.sin_elevation(a) - target;
+		// down to the resolution of the julian date
+		while (true) {
+			double m = (a + c) / 2;
+			if (m == a || m == c)
+				break;
+
+			double fm = eval.sin_elevation(m) - target;
+			if (fm * fa > 0.0) {
+				a = m;
+				fa = fm;
+			}
+			else
+				c = m;
+		}
+		return (a + c) / 2;
+	};
+
+	std::vector<double> reference;
+	for (auto& b : brackets) {
+		reference.push_back(bisect(b, 0.0));
+	}
+
+	std::vector<double> found(brackets.size());
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < brackets.size(); i++) {
+		sgp4_state state{};
+		found[i] = regula_falsi(brackets[i].jd_a, brackets[i].jd_b, observer, *brackets[i].model, state);
+	}
+	std::chrono::duration<double, std::micro> us_rf = std::chrono::steady_clock::now() - start;
+
+	// it returns the middle of the bracket when it stalls
+	double max_rf = 0.0;
+	size_t stalled = 0;
+	for (size_t i = 0; i < brackets.size(); i++) {
+		max_rf = std::max(max_rf, std::fabs(found[i] - reference[i]));
+		if (std::fabs(found[i] - reference[i]) * 86400.0 > 1.0)
+			stalled++;
+	}
+
+	// the scan knows the values at both ends, they are not counted
+	std::vector<double> sin_a(brackets.size()), sin_b(brackets.size());
+	for (size_t i = 0; i < brackets.size(); i++) {
+		elevation_eval_t eval(*brackets[i].model, observer);
+		sin_a[i] = eval.sin_elevation(brackets[i].jd_a);
+		sin_b[i] = eval.sin_elevation(brackets[i].jd_b);
+	}
+
+	size_t evaluations = 0, most = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < brackets.size(); i++) {
+		elevation_eval_t eval(*brackets[i].model, observer);
+		crossing_t c = find_crossing(eval, brackets[i].jd_a, sin_a[i], brackets[i].jd_b, sin_b[i]);
+		found[i] = c.jd;
+		evaluations += c.evaluations;
+		most = std::max(most, c.evaluations);
+	}
+	std::chrono::duration<double, std::micro> us_fc = std::chrono::steady_clock::now() - start;
+
+	double max_fc = 0.0;
+	for (size_t i = 0; i < brackets.size(); i++) {
+		max_fc = std::max(max_fc, std::fabs(found[i] - reference[i]));
+	}
+
+	printf("crossings          : %zu horizon crossings, brackets of 1/20 period\n", brackets.size());
+	printf("  regula_falsi     : %.1f us/crossing, up to 30 propagations, max error %.3g s, %zu off by more than 1 s\n",
+		us_rf.count() / brackets.size(), max_rf * 86400.0, stalled);
+	printf("  find_crossing    : %.1f us/crossing, %.1f propagations (max %zu), max error %.3g s\n",
+		us_fc.count() / brackets.size(), (double)evaluations / brackets.size(), most, max_fc * 86400.0);
+
+	// 10 deg crossings : brackets of one scan step around the crossing found by bisection
+	size_t count = 0;
+	evaluations = 0;
+	double max_10 = 0.0;
+	for (auto& b : brackets) {
+		elevation_eval_t eval(*b.model, observer);
+		double width = b.jd_b - b.jd_a;
+		bool rising = eval.sin_elevation(b.jd_a) < eval.sin_elevation(b.jd_b);
+		double a = rising ? b.jd_a : b.jd_a - 2 * width;
+		double c = rising ? b.jd_b + 2 * width : b.jd_b;
+		double target = std::sin(to_rad(10.0));
+		double sa = eval.sin_elevation(a), sc = eval.sin_elevation(c);
+		if ((sa - target) * (sc - target) >= 0.0)
+			continue;
+
+		double ref = bisect(bracket_t{ b.model, a, c }, to_rad(10.0));
+		elevation_eval_t fresh(*b.model, observer);
+		crossing_t x = find_crossing(fresh, a, sa, c, sc, to_rad(10.0));
+		count++;
+		evaluations += x.evaluations;
+		max_10 = std::max(max_10, std::fabs(x.jd - ref));
+	}
+	printf("  10 deg           : %zu crossings, %.1f propagations, max error %.3g s\n", count,
+		count ? (double)evaluations / count : 0.0, max_10 * 86400.0);
+}
+
+// highest point of one day of passes of the bundled satellites : find_culmination and
+// the middle of the pass, against the elevation sampled every 0.5 s
+static void report_culminations() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("culminations       : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	std::vector<double> epochs;
+	for (const sgp4_model& model : catalog.models()) {
+		epochs.push_back(epoch_jd(model));
+	}
+	std::nth_element(epochs.begin(), epochs.begin() + epochs.size() / 2, epochs.end());
+	double jd_start = epochs[epochs.size() / 2];
+
+	observer_t observer;
+	observer.update(jd_start, geodetic_t{ to_rad(48.85), to_rad(2.35), 0.035 });
+
+	const double sampling = 0.5 / 86400.0;
+	const double filter = 10.0;
+	size_t count = 0, dropped = 0;
+	double max_elev = 0.0, max_time = 0.0, max_mid = 0.0, max_mid_time = 0.0;
+	pass_scan_stats_t stats;
+	for (const sgp4_model& model : catalog.models()) {
+		for (const pass_t& pass : find_passes(model, observer, jd_start, jd_start + 1.0, {}, &stats)) {
+			elevation_eval_t eval(model, observer);
+			double jd_ref = pass.jd_start;
+			double sin_ref = -1.0;
+			for (double jd = pass.jd_start; jd <= pass.jd_end; jd += sampling) {
+				double sin_elev = eval.sin_elevation(jd);
+				if (sin_elev > sin_ref) {
+					sin_ref = sin_elev;
+					jd_ref = jd;
+				}
+			}
+			double elev_ref = to_deg(std::asin(sin_ref));
+
+			double mid = (pass.jd_start + pass.jd_end) / 2;
+			double elev_mid = to_deg(std::asin(eval.sin_elevation(mid)));
+
+			count++;
+			max_elev = std::max(max_elev, elev_ref - to_deg(pass.elev_max));
+			max_time = std::max(max_time, std::fabs(pass.jd_max - jd_ref));
+			max_mid = std::max(max_mid, elev_ref - elev_mid);
+			max_mid_time = std::max(max_mid_time, std::fabs(mid - jd_ref));
+			if (elev_ref >= filter && elev_mid < filter)
+				dropped++;
+		}
+	}
+
+	printf("culminations       : %zu passes, highest point sampled every 0.5 s\n", count);
+	printf("  find_culmination : %.1f propagations per pass, elevation %.4f deg below at most, time off by %.1f s at most\n",
+		stats.culminations ? (double)stats.culmination_evaluations / stats.culminations : 0.0, max_elev, max_time * 86400.0);
+	printf("  middle of pass   : elevation %.2f deg below at most, time off by %.0f s at most, %zu passes above %.0f deg dropped\n",
+		max_mid, max_mid_time * 86400.0, dropped, filter);
+}
+
+// satellites can_rise() drops for a few sites and elevation thresholds, each of them
+// is checked by sampling its elevation every 30 s over 3 days
+static void report_prefilter() {
+	sat_catalog_t catalog;
+	load_bundled(catalog);
+	if (catalog.empty()) {
+		printf("prefilter          : no tle found in data/tle, skipped\n");
+		return;
+	}
+
+	printf("prefilter          : %zu satellites, elevation sampled every 30 s over 3 days\n", catalog.size());
+
+	const double step = 30.0 / 86400.0;
+	const size_t count = 3 * 2880;
+	for (double lat : { 0.0, 48.85, 78.2 }) {
+		for (double min_elev : { 0.0, 10.0, 30.0 }) {
+			size_t eliminated = 0, wrong = 0;
+			double highest = -90.0;
+			for (const sgp4_model& model : catalog.models()) {
+				double jd_start = epoch_jd(model);
+				observer_t observer;
+				observer.update(jd_start, geodetic_t{ to_rad(lat), to_rad(15.0), 0.0 });
+				if (can_rise(model, observer, to_rad(min_elev)))
+					continue;
+
+				eliminated++;
+
+				sgp4_batch_result_t track;
+				sgp4_batch_t::propagate_grid(model, jd_start, step, count, track);
+				sidereal_grid_t sidereal(jd_start, step, observer.geo.lon);
+				double max_sin = -1.0;
+				for (size_t k = 0; k < count; k++) {
+					if (track.error[k] == 0)
+						max_sin = std::max(max_sin, observer.sin_elevation(sidereal.current(), vector_t{ track.x[k], track.y[k], track.z[k] }));
+					sidereal.next();
+				}
+				highest = std::max(highest, to_deg(std::asin(max_sin)));
+				wrong += max_sin >= std::sin(to_rad(min_elev)) ? 1 : 0;
+			}
+
+			printf("  lat %4.1f, > %2.0f deg : %3zu eliminated, highest %6.1f deg, %zu wrongly\n", lat, min_elev, eliminated,
+				eliminated > 0 ? highest : 0.0, wrong);
+		}
+	}
+}
+
+// random times within +/- days of epoch, the integrator moves back and forth
+static void report_deep_random(const char* name, const char* line1, const char* line2, double days) {
+	char longstr1[130], longstr2[130];
+	strcpy(longstr1, line1);
+	strcpy(longstr2, line2);
+
+	double startmfe, stopmfe, deltamin;
+	elsetrec satrec;
+	twoline2rv(longstr1, longstr2, 'c', 'e', 'i', wgs72, startmfe, stopmfe, deltamin, satrec);
+
+	sgp4_model model;
+	makesgp4model(satrec, model);
+
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<double> dist(-days * 1440.0, days * 1440.0);
+	std::vector<double> times(20000);
+	for (auto& t : times) {
+		t = dist(gen);
+	}
+
+	double r[3], v[3];
+	sgp4_state state{};
+	double check_full = 0.0, check_model = 0.0;
+
+	auto time_queries = [&times](auto propagate) {
+		auto start = std::chrono::steady_clock::now();
+		for (double t : times) {
+			propagate(t);
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / times.size();
+	};
+
+	double ns_full = time_queries([&](double t) {
+		sgp4(satrec, t, r, v);
+		check_full += r[0];
+	});
+	double ns_model = time_queries([&](double t) {
+		sgp4(model, state, t, r, v);
+		check_model += r[0];
+	});
+
+	printf("%-20s : irez %d, %zu random queries within +/- %.0f days\n", name, model.deep->irez, times.size(), days);
+	printf("  restart (elsetrec)   : %.1f ns/prop\n", ns_full);
+	printf("  checkpointed (state) : %.1f ns/prop, %zu checkpoints%s\n", ns_model,
+		state.checkpoints.xlipos.size() + state.checkpoints.xlineg.size(),
+		check_full == check_model ? "" : "  (results differ!)");
+
+	// the same deep block refilled with another satellite, at the same address : the
+	// checkpoints the state kept for the first one must not be replayed
+	elsetrec other{};
+	parse_tle_lines(line_pair{ tle_09880[0], tle_09880[1] }, 'a', wgs72, other);
+
+	elsetrec_near nearrec;
+	elsetrec_deep deeprec;
+	sgp4_state reused{}, fresh{};
+	splitelsetrec(satrec, nearrec, &deeprec, nullptr);
+	sgp4(nearrec, &deeprec, reused, days * 1440.0, r, v);
+
+	double r_reused[3], r_fresh[3];
+	splitelsetrec(other, nearrec, &deeprec, nullptr);
+	sgp4(nearrec, &deeprec, reused, days * 1440.0, r_reused, v);
+	sgp4(nearrec, &deeprec, fresh, days * 1440.0, r_fresh, v);
+	printf("  reused state         : deep block refilled with 09880, %.2g km from a fresh state\n", dist3(r_reused, r_fresh));
+}
+
+int main() {
+	if (verify_reference() != 0)
+		return 1;
+
+	report_init(2000);
+	report_catalog(25000);
+	report_bytes();
+	report_sweep(16384, 50);
+	report_grid(256, 1440);
+	report_specialized(16384, 50);
+	report_lunarsolar(2048, 100);
+	report_look_angles(16384);
+	report_observers(4096, 16);
+	report_clock();
+	report_timestamps(100000);
+	report_sidereal();
+	report_geodetic(256);
+	report_ephemeris(2000);
+	report_predictions();
+	report_merge();
+	report_generator();
+	report_cache();
+	report_prefilter();
+	report_pass_scan();
+	report_crossings();
+	report_culminations();
+	report_deep_random("molniya 08195",
+		"1 08195U 75081A   06176.33215444  .00000099  00000-0  11873-3 0   813",
+		"2 08195  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656", 60.0);
+	report_deep_random("geosynchronous 28626",
+		"1 28626U 05008A   06176.46683397 -.00000205  00000-0  10000-3 0  2190",
+		"2 28626   0.0019 286.9433 0000335  13.7918  55.6504  1.00270176  4891", 60.0);
+	return 0;
+}
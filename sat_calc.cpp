@@ -2,7 +2,15 @@
 #include <time.h>
 #include <fstream>
 #include <locale>
+#include <algorithm>
 #include <format>
+#include <cstring>
+
+// SSE2 is part of x64, and the default of the 32 bits msvc target
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SAT_CALC_SSE2
+#endif
 
 // Convert to greenwich mean sidereal time
 double to_gmst(double jd) {
@@ -32,6 +40,46 @@ double reduce(double value, double rangeMin, double rangeMax) {
 	return retval;
 }
 
+sidereal_grid_t::sidereal_grid_t(double jd_start, double jd_step, double lon, int reanchor)
+	: jd_start_(jd_start)
+	, jd_step_(jd_step)
+	, lon_(lon)
+	, reanchor_(reanchor > 0 ? reanchor : default_reanchor) {
+
+	// to_gmst turns at OMEGA_E revolutions per day
+	step_ = std::fmod(2.0 * M_PI * OMEGA_E * jd_step, 2.0 * M_PI);
+	sin_step_ = std::sin(step_);
+	cos_step_ = std::cos(step_);
+
+	_anchor();
+}
+
+void sidereal_grid_t::_anchor() {
+	double theta = to_lmst(jd(), lon_);
+
+	st_ = sidereal_t{ theta, std::sin(theta), std::cos(theta) };
+}
+
+void sidereal_grid_t::next() {
+	k_++;
+
+	double s = st_.sin_theta * cos_step_ + st_.cos_theta * sin_step_;
+	double c = st_.cos_theta * cos_step_ - st_.sin_theta * sin_step_;
+	double theta = st_.theta + step_;
+	if (theta >= 2.0 * M_PI)
+		theta -= 2.0 * M_PI;
+
+	st_ = sidereal_t{ theta, s, c };
+
+	if (k_ % reanchor_ == 0) {
+		sidereal_t stepped = st_;
+		_anchor();
+
+		// sine of the angle between the stepped and the direct values
+		max_drift_ = std::max(max_drift_, std::fabs(st_.sin_theta * stepped.cos_theta - st_.cos_theta * stepped.sin_theta));
+	}
+}
+
 void eci_pos_t::update(double jd, const geodetic_t& g) {
 	double theta = to_lmst(jd, g.lon);
 
@@ -43,7 +91,51 @@ void eci_pos_t::update(double jd, const geodetic_t& g) {
 	vel.set(-MFACTOR * pos.y, MFACTOR * pos.x, 0.0);
 }
 
-void geodetic_t::update(double jd, const eci_pos_t& pv) {
+namespace {
+
+	// Vermeille, "Direct transformation from geocentric coordinates to geodetic
+	// coordinates", Journal of Geodesy 76, 2002. Exact for points outside the
+	// evolute of the ellipsoid, a few hundred km around the earth center
+	inline void vermeille(double x, double y, double z, double& lat, double& alt) {
+		constexpr double e2 = EARTH_FLAT * (2 - EARTH_FLAT);
+		constexpr double e4 = e2 * e2;
+		constexpr double a2 = EARTH_RADIUS_KM * EARTH_RADIUS_KM;
+
+		double rho2 = x * x + y * y;
+		double p = rho2 / a2;
+		double q = (1 - e2) * z * z / a2;
+		double r = (p + q - e4) / 6.0;
+		double s = e4 * p * q / (4.0 * r * r * r);
+		double t = std::cbrt(1.0 + s + std::sqrt(s * (2.0 + s)));
+		double u = r * (1.0 + t + 1.0 / t);
+		double v = std::sqrt(u * u + e4 * q);
+		double w = e2 * (u + v - q) / (2.0 * v);
+		double k = std::sqrt(u + v + w * w) - w;
+		double d = k * std::sqrt(rho2) / (k + e2);
+		double dz = std::sqrt(d * d + z * z);
+
+		lat = 2.0 * std::atan2(z, d + dz);
+		alt = (k + e2 - 1.0) / k * dz;
+	}
+}
+
+void geodetic_t::_update(double gmst, const eci_pos_t& pv) {
+	double theta = std::atan2(pv.pos.y, pv.pos.x);
+
+	lon = reduce(theta - gmst, -M_PI, M_PI);
+	vermeille(pv.pos.x, pv.pos.y, pv.pos.z, lat, alt);
+}
+
+void to_geodetic(const double* x, const double* y, const double* z, const double* gmst, size_t count, geodetic_soa_t& out) {
+	out.resize(count);
+
+	for (size_t k = 0; k < count; k++) {
+		out.lon[k] = reduce(std::atan2(y[k], x[k]) - gmst[k], -M_PI, M_PI);
+		vermeille(x[k], y[k], z[k], out.lat[k], out.alt[k]);
+	}
+}
+
+void geodetic_t::update_iterative(double jd, const eci_pos_t& pv) {
 	double theta = std::atan2(pv.pos.y, pv.pos.x);
 
 	lon = reduce(theta - to_gmst(jd), -M_PI, M_PI);
@@ -67,23 +159,27 @@ void geodetic_t::update(double jd, const eci_pos_t& pv) {
 		lat -= 2 * M_PI;
 }
 
-topocentric_t observer_t::get_lookup_angle(double jd, const eci_pos_t& obj) {
-	eci.update(jd, geo);
+void observer_t::_set_frame() {
+	sin_lat_ = std::sin(geo.lat);
+	cos_lat_ = std::cos(geo.lat);
 
-	vector_t range = obj.pos - eci.pos;
-	vector_t rgvel = obj.vel - eci.vel;
+	double c = 1.0 / std::sqrt(1.0 + EARTH_FLAT * (EARTH_FLAT - 2.0) * sqr(sin_lat_));
+	double sq = sqr(1 - EARTH_FLAT) * c;
 
-	double theta = to_lmst(jd, geo.lon);
+	achcp_ = (EARTH_RADIUS_KM * c + geo.alt) * cos_lat_;
+	z_ = (EARTH_RADIUS_KM * sq + geo.alt) * sin_lat_;
+}
 
-	double sin_lat = std::sin(geo.lat);
-	double cos_lat = std::cos(geo.lat);
+topocentric_t observer_t::get_lookup_angle(const sidereal_t& st, const eci_pos_t& obj) const {
+	vector_t pos = position(st);
+	vector_t vel{ -MFACTOR * pos.y, MFACTOR * pos.x, 0.0 };
 
-	double sin_theta = std::sin(theta);
-	double cos_theta = std::cos(theta);
+	vector_t range = obj.pos - pos;
+	vector_t rgvel = obj.vel - vel;
 
-	double top_s = sin_lat * cos_theta * range.x + sin_lat * sin_theta * range.y - cos_lat * range.z;
-	double top_e = -sin_theta * range.x + cos_theta * range.y;
-	double top_z = cos_lat * cos_theta * range.x + cos_lat * sin_theta * range.y + sin_lat * range.z;
+	double top_s = sin_lat_ * st.cos_theta * range.x + sin_lat_ * st.sin_theta * range.y - cos_lat_ * range.z;
+	double top_e = -st.sin_theta * range.x + st.cos_theta * range.y;
+	double top_z = cos_lat_ * st.cos_theta * range.x + cos_lat_ * st.sin_theta * range.y + sin_lat_ * range.z;
 	double azim = std::atan(-top_e / top_s);
 
 	if (top_s > 0.0)
@@ -92,9 +188,130 @@ topocentric_t observer_t::get_lookup_angle(double jd, const eci_pos_t& obj) {
 	if (azim < 0.0)
 		azim = azim + 2.0 * M_PI;
 
-	double el = std::asin(top_z / range.mag());
+	double range_mag = range.mag();
+	double el = std::asin(top_z / range_mag);
 
-	return topocentric_t(azim, el, range.mag(), range.dot(rgvel) / range.mag());
+	return topocentric_t(azim, el, range_mag, range.dot(rgvel) / range_mag);
+}
+
+void observer_set_t::clear() {
+	geo_.clear();
+	for (auto* v : { &x_, &y_, &z_, &sx_, &sy_, &sz_, &ex_, &ey_, &zx_, &zy_, &zz_ }) {
+		v->clear();
+	}
+}
+
+size_t observer_set_t::add(const geodetic_t& g) {
+	// same position as observer_t at a zero sidereal angle
+	observer_t site;
+	site.update(0.0, g);
+	vector_t pos = site.position(sidereal_t{ g.lon, std::sin(g.lon), std::cos(g.lon) });
+
+	double sin_lat = std::sin(g.lat);
+	double cos_lat = std::cos(g.lat);
+	double sin_lon = std::sin(g.lon);
+	double cos_lon = std::cos(g.lon);
+
+	geo_.push_back(g);
+	x_.push_back(pos.x);
+	y_.push_back(pos.y);
+	z_.push_back(pos.z);
+	sx_.push_back(sin_lat * cos_lon);
+	sy_.push_back(sin_lat * sin_lon);
+	sz_.push_back(-cos_lat);
+	ex_.push_back(-sin_lon);
+	ey_.push_back(cos_lon);
+	zx_.push_back(cos_lat * cos_lon);
+	zy_.push_back(cos_lat * sin_lon);
+	zz_.push_back(sin_lat);
+
+	return geo_.size() - 1;
+}
+
+void observer_set_t::observe(const sidereal_t& gst, const eci_pos_t& obj, observer_view_t& out) const {
+	// satellite in earth fixed coordinates, velocity relative to the rotating earth
+	double px = gst.cos_theta * obj.pos.x + gst.sin_theta * obj.pos.y;
+	double py = -gst.sin_theta * obj.pos.x + gst.cos_theta * obj.pos.y;
+	double pz = obj.pos.z;
+	double vx = gst.cos_theta * obj.vel.x + gst.sin_theta * obj.vel.y + MFACTOR * py;
+	double vy = -gst.sin_theta * obj.vel.x + gst.cos_theta * obj.vel.y - MFACTOR * px;
+	double vz = obj.vel.z;
+
+	const size_t n = geo_.size();
+	if (out.size() != n)
+		out.resize(n);
+	out.pos = vector_t{ px, py, pz };
+
+	const double* x = x_.data(), * y = y_.data(), * z = z_.data();
+	const double* zx = zx_.data(), * zy = zy_.data(), * zz = zz_.data();
+	double* range = out.range.data(), * range_rate = out.range_rate.data(), * sin_el = out.sin_el.data();
+
+	size_t i = 0;
+#ifdef SAT_CALC_SSE2
+	// two sites per step
+	auto madd = [](__m128d a, __m128d b, __m128d c) {
+		return _mm_add_pd(_mm_mul_pd(a, b), c);
+	};
+	const __m128d ppx = _mm_set1_pd(px), ppy = _mm_set1_pd(py), ppz = _mm_set1_pd(pz);
+	const __m128d pvx = _mm_set1_pd(vx), pvy = _mm_set1_pd(vy), pvz = _mm_set1_pd(vz);
+	const __m128d one = _mm_set1_pd(1.0);
+	for (; i + 2 <= n; i += 2) {
+		__m128d rx = _mm_sub_pd(ppx, _mm_loadu_pd(x + i));
+		__m128d ry = _mm_sub_pd(ppy, _mm_loadu_pd(y + i));
+		__m128d rz = _mm_sub_pd(ppz, _mm_loadu_pd(z + i));
+
+		__m128d tz = madd(_mm_loadu_pd(zx + i), rx, madd(_mm_loadu_pd(zy + i), ry, _mm_mul_pd(_mm_loadu_pd(zz + i), rz)));
+
+		__m128d r = _mm_sqrt_pd(madd(rx, rx, madd(ry, ry, _mm_mul_pd(rz, rz))));
+		__m128d inv = _mm_div_pd(one, r);
+		__m128d rate = madd(rx, pvx, madd(ry, pvy, _mm_mul_pd(rz, pvz)));
+
+		_mm_storeu_pd(range + i, r);
+		_mm_storeu_pd(range_rate + i, _mm_mul_pd(rate, inv));
+		_mm_storeu_pd(sin_el + i, _mm_mul_pd(tz, inv));
+	}
+#endif
+	for (; i < n; i++) {
+		double rx = px - x[i];
+		double ry = py - y[i];
+		double rz = pz - z[i];
+
+		double top_z = zx[i] * rx + zy[i] * ry + zz[i] * rz;
+
+		double r = std::sqrt(rx * rx + ry * ry + rz * rz);
+		double inv = 1.0 / r;
+		range[i] = r;
+		range_rate[i] = (rx * vx + ry * vy + rz * vz) * inv;
+		sin_el[i] = top_z * inv;
+	}
+}
+
+void observer_set_t::observe(const sidereal_t* gst, const eci_pos_t* obj, size_t count, observer_view_t* out) const {
+	for (size_t k = 0; k < count; k++) {
+		observe(gst[k], obj[k], out[k]);
+	}
+}
+
+topocentric_t observer_set_t::look_angle(const observer_view_t& view, size_t i) const {
+	double rx = view.pos.x - x_[i];
+	double ry = view.pos.y - y_[i];
+	double rz = view.pos.z - z_[i];
+
+	double top_s = sx_[i] * rx + sy_[i] * ry + sz_[i] * rz;
+	double top_e = ex_[i] * rx + ey_[i] * ry;
+
+	double azim = std::atan2(top_e, -top_s);
+	if (azim < 0.0)
+		azim = azim + 2.0 * M_PI;
+
+	return topocentric_t(azim, std::asin(view.sin_el[i]), view.range[i], view.range_rate[i]);
+}
+
+void observer_set_t::get_lookup_angles(const sidereal_t& gst, const eci_pos_t& obj, observer_view_t& view, topocentric_t* out) const {
+	observe(gst, obj, view);
+	for (size_t i = 0; i < view.size(); i++) {
+		out[i] = look_angle(view, i);
+	}
 }
 
 static bool tle_checksum(const std::string& buff) {
@@ -210,6 +427,18 @@ inline double get_element_impldec(const std::string src, int start, int end) {
 	return std::stod(n);
 }
 
+uint64_t tle_hash(const line_pair& tle_data) {
+	uint64_t hash = 14695981039346656037ull;
+	for (const std::string* line : { &tle_data.l1, &tle_data.l2 }) {
+		for (unsigned char c : *line) {
+			hash = (hash ^ c) * 1099511628211ull;
+		}
+		hash = (hash ^ '\n') * 1099511628211ull;
+	}
+
+	return hash;
+}
+
 void parse_tle_lines(const line_pair& tle_data, char opsmode, gravconsttype whichconst, elsetrec& satrec) {
 
 	satrec.error = 0;
@@ -348,31 +577,39 @@ std::map<std::string, line_pair> load_tle_file(const std::string& filename) {
 	return list;
 }
 
-eci_pos_t get_sat_pos(double t_since, elsetrec& satrec) {
-	if (satrec.init != 'n') {
-		satrec.error = 7;	// custom : not initialzed
+sat_model_ptr make_sat_model(const elsetrec& satrec) {
+	auto model = std::make_shared<sgp4_model>();
+	SGP4Funcs::makesgp4model(satrec, *model);
+
+	return model;
+}
+
+eci_pos_t get_sat_pos(double t_since, const sgp4_model& model, sgp4_state& state) {
+	if (model.meta.init != 'n') {
+		state.error = 7;	// custom : not initialzed
 
 		return eci_pos_t{};
 	}
 
 	double sat_vel[3], sat_pos[3];
-	bool res = SGP4Funcs::sgp4(satrec, t_since, sat_pos, sat_vel);
+	bool res = SGP4Funcs::sgp4(model, state, t_since, sat_pos, sat_vel);
 	if (!res)
 		return eci_pos_t{};
 
 	return eci_pos_t{ sat_pos, sat_vel };
 }
 
-int get_orbit_num(double jd, const elsetrec& satrec) {
+int get_orbit_num(double jd, const sgp4_model& model) {
+	const elsetrec_meta& meta = model.meta;
 
-	double dT = (jd - (satrec.jdsatepoch + satrec.jdsatepochF));	// (days)
+	double dT = (jd - epoch_jd(model));	// (days)
 	double dT2 = dT * dT;	// (day^2)
 
-	double epochMeanMotion = satrec.no_kozai * 1440 / (2.0 * M_PI);			// (rev/day)
-	double decayRate = satrec.ndot * 1440 * 1440 / (2.0 * M_PI);			// (rev/day^2)
-	double decayRateDot = satrec.nddot * 1440 * 1440 * 1440 / (2.0 * M_PI);	// (rev/day^3)
+	double epochMeanMotion = meta.no_kozai * 1440 / (2.0 * M_PI);			// (rev/day)
+	double decayRate = meta.ndot * 1440 * 1440 / (2.0 * M_PI);			// (rev/day^2)
+	double decayRateDot = meta.nddot * 1440 * 1440 * 1440 / (2.0 * M_PI);	// (rev/day^3)
 	double curMotion = epochMeanMotion + 2.0 * decayRate * dT + 6.0 * decayRateDot * dT2;	// current number of rev/day
-	double refOrbit = (double)satrec.revnum + satrec.mo / (2.0*M_PI);		 // (rev)
+	double refOrbit = (double)meta.revnum + model.near.mo / (2.0*M_PI);		 // (rev)
 
 	return (int)(refOrbit + curMotion * dT);
 }
@@ -380,7 +617,11 @@ int get_orbit_num(double jd, const elsetrec& satrec) {
 double tz_seconds() {
 	time_t now = time(NULL);
 	struct tm utctm;
+#ifdef _WIN32
 	gmtime_s(&utctm, &now);
+#else
+	gmtime_r(&now, &utctm);
+#endif
 	utctm.tm_isdst = -1;
 	time_t utctt = mktime(&utctm);
 	return difftime(now, utctt);
@@ -431,11 +672,263 @@ std::string julian_to_string(double jd, bool utc) {
 	return str;
 }
 
-std::tuple<double, double> calc_azm_elev(double jd, observer_t& observer, elsetrec& satrec) {
-	double tle_date = satrec.jdsatepoch + satrec.jdsatepochF;
+const elevation_eval_t::entry_t& elevation_eval_t::_eval(double jd) {
+	for (size_t i = 0; i < used_; i++) {
+		if (cache_[i].jd == jd)
+			return cache_[i];
+	}
+
+	// oldest entry replaced once the cache is full
+	entry_t& e = cache_[evaluations_ % cache_size];
+	used_ = std::min(used_ + 1, cache_size);
+	evaluations_++;
+
+	e.jd = jd;
+	e.pos = get_sat_pos((jd - epoch_jd(model_)) * 1440, model_, state_);
+	e.sin_elevation = state_.error == 0 ? observer_.sin_elevation(observer_.sidereal(jd), e.pos.pos) : 0.0;
+
+	return e;
+}
+
+double elevation_eval_t::sin_elevation(double jd) {
+	return _eval(jd).sin_elevation;
+}
+
+topocentric_t elevation_eval_t::look(double jd) {
+	return observer_.get_lookup_angle(jd, _eval(jd).pos);
+}
+
+crossing_t find_crossing(elevation_eval_t& eval, double jd_a, double sin_a, double jd_b, double sin_b,
+	double threshold, double tol) {
+	const int max_iter = 60;
+	size_t start = eval.evaluations();
+
+	double target = std::sin(threshold);
+	double fa = sin_a - target;
+	double fb = sin_b - target;
+
+	for (int i = 0; i < max_iter && std::fabs(jd_b - jd_a) >= tol; i++) {
+		double jd = (jd_a * fb - jd_b * fa) / (fb - fa);
+		if (!(jd > std::min(jd_a, jd_b) && jd < std::max(jd_a, jd_b)))
+			jd = (jd_a + jd_b) / 2;	// equal values at both ends, or rounding outside the bracket
+
+		double f = eval.sin_elevation(jd) - target;
+		if (eval.error() != 0)
+			return crossing_t{ -1.0, eval.evaluations() - start };
 
-	eci_pos_t sat = get_sat_pos((jd - tle_date) * 1440, satrec);
-	if (satrec.error != 0)
+		if (f == 0.0)
+			return crossing_t{ jd, eval.evaluations() - start };
+
+		// b is always the last point, a the other end of the bracket
+		if (f * fb < 0.0) {
+			jd_a = jd_b;
+			fa = fb;
+		}
+		else
+			fa /= 2;	// a stays in place
+
+		jd_b = jd;
+		fb = f;
+	}
+
+	// the end closest to the threshold, it is in the cache
+	return crossing_t{ std::fabs(fa) < std::fabs(fb) ? jd_a : jd_b, eval.evaluations() - start };
+}
+
+culmination_t find_culmination(elevation_eval_t& eval, double jd_a, double jd_b, double tol) {
+	const double golden = 0.3819660112501051;	// (3 - sqrt(5)) / 2
+	const int max_iter = 40;
+	size_t start = eval.evaluations();
+
+	// minimum of -sin(elevation), on the time since jd_a : the julian dates are too
+	// large for a tolerance relative to them
+	auto f = [&](double t) {
+		return -eval.sin_elevation(jd_a + t);
+	};
+
+	double a = 0.0;
+	double b = jd_b - jd_a;
+
+	// x : best point, w : second best, v : previous w
+	double x = b / 2;
+	double fx = f(x);
+	if (eval.error() != 0)
+		return culmination_t{ -1.0, 0.0, eval.evaluations() - start };
+
+	double w = x, v = x;
+	double fw = fx, fv = fx;
+	double d = 0.0;	// last step
+	double e = 0.0;	// step before the last one
+
+	for (int i = 0; i < max_iter; i++) {
+		double m = (a + b) / 2;
+		if (std::fabs(x - m) <= 2 * tol - (b - a) / 2)
+			break;
+
+		bool parabolic = false;
+		if (std::fabs(e) > tol) {
+			// vertex of the parabola through x, w, v : x + p / q
+			double r = (x - w) * (fx - fv);
+			double q = (x - v) * (fx - fw);
+			double p = (x - v) * q - (x - w) * r;
+			q = 2 * (q - r);
+			if (q > 0.0)
+				p = -p;
+			else
+				q = -q;
+
+			// taken when it falls inside the bracket and moves less than half the step before last
+			if (std::fabs(p) < std::fabs(q * e / 2) && p > q * (a - x) && p < q * (b - x)) {
+				e = d;
+				d = p / q;
+				if ((x + d) - a < 2 * tol || b - (x + d) < 2 * tol)
+					d = std::copysign(tol, m - x);
+				parabolic = true;
+			}
+		}
+
+		if (!parabolic) {
+			e = (x >= m) ? a - x : b - x;
+			d = golden * e;
+		}
+
+		double u = (std::fabs(d) >= tol) ? x + d : x + std::copysign(tol, d);
+		double fu = f(u);
+		if (eval.error() != 0)
+			return culmination_t{ -1.0, 0.0, eval.evaluations() - start };
+
+		if (fu <= fx) {
+			if (u >= x)
+				a = x;
+			else
+				b = x;
+			v = w;
+			fv = fw;
+			w = x;
+			fw = fx;
+			x = u;
+			fx = fu;
+		}
+		else {
+			if (u < x)
+				a = u;
+			else
+				b = u;
+			if (fu <= fw || w == x) {
+				v = w;
+				fv = fw;
+				w = u;
+				fw = fu;
+			}
+			else if (fu <= fv || v == x || v == w) {
+				v = u;
+				fv = fu;
+			}
+		}
+	}
+
+	return culmination_t{ jd_a + x, -fx, eval.evaluations() - start };
+}
+
+julian_formatter_t::julian_formatter_t(bool utc)
+	: utc_(utc)
+	, order_(std::use_facet<std::time_get<char> >(std::locale("")).date_order()) {
+	if (!utc)
+		tz_days_ = tz_seconds() / (60 * 60 * 24);
+}
+
+namespace {
+
+	inline char* put2(char* p, int v) {
+		p[0] = (char)('0' + v / 10);
+		p[1] = (char)('0' + v % 10);
+
+		return p + 2;
+	}
+
+	inline char* put4(char* p, int v) {
+		put2(p, v / 100);
+		put2(p + 2, v % 100);
+
+		return p + 4;
+	}
+}
+
+size_t julian_formatter_t::format(double jd, char* buf) const {
+	int year, mon, day;
+	int hr, minute;
+	double sec;
+
+	if (!utc_)
+		jd += tz_days_;
+
+	SGP4Funcs::invjday_SGP4(jd, 0.0, year, mon, day, hr, minute, sec);
+
+	int isec = (int)sec;
+
+	// fields std::format would write on more than their width go through it
+	if (year < 0 || year > 9999 || mon < 0 || mon > 99 || day < 0 || day > 99 || hr < 0 || hr > 99
+		|| minute < 0 || minute > 99 || isec < 0 || isec > 99) {
+		const char* utc = utc_ ? " (UTC)" : "";
+		std::format_to_n_result<char*> res;
+		switch (order_) {
+		case std::time_get<char>::mdy:
+			res = std::format_to_n(buf, max_length - 1, "{:02d}/{:02d}/{:04d} {:02d}:{:02d}:{:02d}{}", mon, day, year, hr, minute, isec, utc);
+			break;
+
+		case std::time_get<char>::ymd:
+			res = std::format_to_n(buf, max_length - 1, "{:04d}/{:02d}/{:02d} {:02d}:{:02d}:{:02d}{}", year, mon, day, hr, minute, isec, utc);
+			break;
+
+		case std::time_get<char>::ydm:
+			res = std::format_to_n(buf, max_length - 1, "{:04d}/{:02d}/{:02d} {:02d}:{:02d}:{:02d}{}", year, day, mon, hr, minute, isec, utc);
+			break;
+
+		default:
+			res = std::format_to_n(buf, max_length - 1, "{:02d}/{:02d}/{:04d} {:02d}:{:02d}:{:02d}{}", day, mon, year, hr, minute, isec, utc);
+			break;
+		}
+		*res.out = '\0';
+
+		return res.out - buf;
+	}
+
+	char* p = buf;
+	switch (order_) {
+	case std::time_get<char>::mdy:
+		p = put2(p, mon); *p++ = '/'; p = put2(p, day); *p++ = '/'; p = put4(p, year);
+		break;
+
+	case std::time_get<char>::ymd:
+		p = put4(p, year); *p++ = '/'; p = put2(p, mon); *p++ = '/'; p = put2(p, day);
+		break;
+
+	case std::time_get<char>::ydm:
+		p = put4(p, year); *p++ = '/'; p = put2(p, day); *p++ = '/'; p = put2(p, mon);
+		break;
+
+	default:	// dmy
+		p = put2(p, day); *p++ = '/'; p = put2(p, mon); *p++ = '/'; p = put4(p, year);
+		break;
+	}
+
+	*p++ = ' ';
+	p = put2(p, hr); *p++ = ':'; p = put2(p, minute); *p++ = ':'; p = put2(p, isec);
+
+	if (utc_) {
+		std::memcpy(p, " (UTC)", 6);
+		p += 6;
+	}
+	*p = '\0';
+
+	return p - buf;
+}
+
+std::tuple<double, double> calc_azm_elev(double jd, const observer_t& observer, const sgp4_model& model, sgp4_state& state) {
+	double tle_date = epoch_jd(model);
+
+	eci_pos_t sat = get_sat_pos((jd - tle_date) * 1440, model, state);
+	if (state.error != 0)
 		return { -1.0, -1.0 };
 
 	topocentric_t topo = observer.get_lookup_angle(jd, sat);
@@ -443,19 +936,17 @@ std::tuple<double, double> calc_azm_elev(double jd, observer_t& observer, elsetr
 	return { topo.azimuth, topo.elevation };
 }
 
-double calc_elev(double jd, observer_t& observer, elsetrec& satrec) {
-	double tle_date = satrec.jdsatepoch + satrec.jdsatepochF;
+double calc_elev(double jd, const observer_t& observer, const sgp4_model& model, sgp4_state& state) {
+	double tle_date = epoch_jd(model);
 
-	eci_pos_t sat = get_sat_pos((jd - tle_date) * 1440, satrec);
-	if (satrec.error != 0)
+	eci_pos_t sat = get_sat_pos((jd - tle_date) * 1440, model, state);
+	if (state.error != 0)
 		return 0.0;
 
-	topocentric_t topo = observer.get_lookup_angle(jd, sat);
-
-	return topo.elevation;
+	return std::asin(observer.sin_elevation(observer.sidereal(jd), sat.pos));
 }
 
-double regula_falsi(double xg, double xd, observer_t& observer, elsetrec& satrec) {
+double regula_falsi(double xg, double xd, const observer_t& observer, const sgp4_model& model, sgp4_state& state) {
 	const double eps = 1e-7;
 
 	double yg = 0.0;
@@ -463,17 +954,17 @@ double regula_falsi(double xg, double xd, observer_t& observer, elsetrec& satrec
 	double yk = 0.0;
 
 	for (int i = 0; i < 10; i++) {
-		yg = calc_elev(xg, observer, satrec);
-		if (satrec.error != 0)
+		yg = calc_elev(xg, observer, model, state);
+		if (state.error != 0)
 			return -1.0;
 
-		yd = calc_elev(xd, observer, satrec);
-		if (satrec.error != 0)
+		yd = calc_elev(xd, observer, model, state);
+		if (state.error != 0)
 			return -1.0;
 
 		double xk = (xg * yd - xd * yg) / (yd - yg);
-		yk = calc_elev(xk, observer, satrec);
-		if (satrec.error != 0)
+		yk = calc_elev(xk, observer, model, state);
+		if (state.error != 0)
 			return -1.0;
 
 
@@ -5,6 +5,10 @@
 #include <string>
 #include <map>
 #include <ctime>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
 
 #include "SGP4.h"
 
@@ -43,9 +47,11 @@ inline double to_deg(double angle) {
 double reduce(double value, double rangeMin, double rangeMax);
 
 // julian date, days from 4713 bc
+// system clock, sub-millisecond resolution. The plugin reads the date from sat_clock_t
 inline double julian_now() {
 	constexpr double jan_1970 = 2440587.5;	// January 1, 1970 at midnight (00:00:00) 
-	return jan_1970 + time(NULL) / 86400.0; // time() returns an UTC time
+	std::chrono::duration<double> since_1970 = std::chrono::system_clock::now().time_since_epoch();	// UTC, unix epoch
+	return jan_1970 + since_1970.count() / 86400.0;
 }
 
 // Modified julian date since the j2000 epoch (January 1, 2000, at 12:00 TT)
@@ -69,6 +75,30 @@ double tz_seconds();
 
 std::string julian_to_string(double jd, bool utc);
 
+// Same strings as julian_to_string, for tables of dates : the locale date order and
+// the UTC offset are resolved once by the constructor, the date is written into the
+// caller buffer without allocation
+class julian_formatter_t {
+public:
+	static constexpr size_t max_length = 48;	// buffer size, terminating null included
+
+	explicit julian_formatter_t(bool utc);
+
+	// returns the length, without the terminating null
+	size_t format(double jd, char* buf) const;
+
+	std::string to_string(double jd) const {
+		char buf[max_length];
+
+		return std::string(buf, format(jd, buf));
+	}
+
+private:
+	bool utc_;
+	double tz_days_{};
+	int order_;	// std::time_get<char>::dateorder
+};
+
 struct vector_t {
 	double x, y, z;
 
@@ -187,6 +217,56 @@ inline vector_t operator*(const vector_t& v, const rot_matrix_t& m) {
 	};
 }
 
+// Local sidereal angle of an observer at one date, with its sine and cosine.
+// Computed once per date and shared by all the satellites looked at that date.
+struct sidereal_t {
+	double theta;
+	double sin_theta;
+	double cos_theta;
+};
+
+// Sidereal angles of the uniform grid jd_start + k * jd_step, for scans over time.
+// to_gmst is evaluated once, then sin/cos are advanced by a fixed rotation per step.
+// Every reanchor steps the angle is set back to the direct formula, the largest
+// difference found there is the drift bound of the grid.
+class sidereal_grid_t {
+public:
+	static constexpr int default_reanchor = 128;
+
+	// lon = 0 gives the greenwich angle, the observer longitude its local angle
+	sidereal_grid_t(double jd_start, double jd_step, double lon = 0.0, int reanchor = default_reanchor);
+
+	const sidereal_t& current() const {
+		return st_;
+	}
+
+	double jd() const {
+		return jd_start_ + (double)k_ * jd_step_;
+	}
+
+	void next();
+
+	// largest angle between the stepped and the direct values, at the re-anchors (rad)
+	double max_drift() const {
+		return max_drift_;
+	}
+
+private:
+	void _anchor();
+
+	double jd_start_;
+	double jd_step_;
+	double lon_;
+	int reanchor_;
+
+	size_t k_{};
+	sidereal_t st_{};
+	double sin_step_;
+	double cos_step_;
+	double step_;	// rotation per step (rad)
+	double max_drift_{};
+};
+
 struct geodetic_t;
 
 // Earth-centered inertial position
@@ -227,11 +307,43 @@ struct geodetic_t {
 		update(jd, pv);
 	}
 
-	void update(double jd, const eci_pos_t& pv);
+	// gst : greenwich sidereal angle of the date, from a sidereal_grid_t
+	geodetic_t(const sidereal_t& gst, const eci_pos_t& pv) {
+		update(gst, pv);
+	}
+
+	void update(double jd, const eci_pos_t& pv) {
+		_update(to_gmst(jd), pv);
+	}
+
+	void update(const sidereal_t& gst, const eci_pos_t& pv) {
+		_update(gst.theta, pv);
+	}
+
+	// fixed point iteration on the latitude, the former conversion kept as reference
+	void update_iterative(double jd, const eci_pos_t& pv);
 
 	double lat, lon, alt;
+
+private:
+	void _update(double gmst, const eci_pos_t& pv);
 };
 
+// Geodetic coordinates of arrays of positions, one array per component
+struct geodetic_soa_t {
+	std::vector<double> lat, lon, alt;
+
+	void resize(size_t n) {
+		lat.resize(n);
+		lon.resize(n);
+		alt.resize(n);
+	}
+};
+
+// closed form conversion of count inertial positions (km), gmst[k] is the greenwich
+// sidereal angle of position k. Same results as geodetic_t::update
+void to_geodetic(const double* x, const double* y, const double* z, const double* gmst, size_t count, geodetic_soa_t& out);
+
 struct topocentric_t {
 public:
 	topocentric_t() = default;
@@ -255,6 +367,7 @@ struct observer_t {
 	observer_t(double la, double lo, double al)
 		: geo(la, lo, al)
 		, eci(julian_now(), geo) {
+		_set_frame();
 	}
 
 	void reset(double la, double lo, double al) {
@@ -264,12 +377,118 @@ struct observer_t {
 	void update(double jd, const geodetic_t& g) {
 		geo = g;
 		eci.update(jd, g);
+		_set_frame();
 	}
 
-	topocentric_t get_lookup_angle(double jd, const eci_pos_t& obj);
+	sidereal_t sidereal(double jd) const {
+		double theta = to_lmst(jd, geo.lon);
+
+		return sidereal_t{ theta, std::sin(theta), std::cos(theta) };
+	}
+
+	topocentric_t get_lookup_angle(double jd, const eci_pos_t& obj) const {
+		return get_lookup_angle(sidereal(jd), obj);
+	}
+
+	topocentric_t get_lookup_angle(const sidereal_t& st, const eci_pos_t& obj) const;
+
+	// sine of the elevation of pos, no transcendental call : its sign tells if the
+	// object is above the horizon, compare it to sin(threshold) for other limits
+	double sin_elevation(const sidereal_t& st, const vector_t& pos) const {
+		vector_t range = pos - position(st);
+		double top_z = cos_lat_ * st.cos_theta * range.x + cos_lat_ * st.sin_theta * range.y + sin_lat_ * range.z;
+
+		return top_z / range.mag();
+	}
+
+	// inertial position of the observer
+	vector_t position(const sidereal_t& st) const {
+		return vector_t{ achcp_ * st.cos_theta, achcp_ * st.sin_theta, z_ };
+	}
 
 	geodetic_t geo;
 	eci_pos_t eci;
+
+private:
+	// terms which only depend on the latitude and the altitude
+	void _set_frame();
+
+	double sin_lat_{};
+	double cos_lat_{ 1.0 };
+	double achcp_{};	// distance to the earth axis (km)
+	double z_{};		// distance to the equatorial plane (km)
+};
+
+// View of one satellite state from the sites of an observer_set_t, one array per term :
+// index i is site i. The angles are only computed by observer_set_t::look_angle, for
+// the sites the caller needs them, usually the ones where sin_el > 0
+struct observer_view_t {
+	vector_t pos;	// earth fixed position of the satellite (km)
+
+	std::vector<double> range;		// (km)
+	std::vector<double> range_rate;	// (km/s)
+	std::vector<double> sin_el;		// sine of the elevation, see observer_t::sin_elevation
+
+	size_t size() const {
+		return range.size();
+	}
+
+	void resize(size_t n) {
+		range.resize(n);
+		range_rate.resize(n);
+		sin_el.resize(n);
+	}
+};
+
+// Several sites observing the same satellites. The satellite state is rotated to earth
+// fixed coordinates once per instant, then the range, range rate and elevation sine of
+// each site only cost a few multiply-adds on its own terms, stored one array per term,
+// a square root and a division. The azimuth and elevation need an atan2 and an asin,
+// look_angle computes them for one site. The sites take the greenwich sidereal angle
+class observer_set_t {
+public:
+	observer_set_t() = default;
+
+	void clear();
+
+	// returns the index of the site
+	size_t add(const geodetic_t& g);
+
+	size_t size() const {
+		return geo_.size();
+	}
+
+	const geodetic_t& geo(size_t i) const {
+		return geo_[i];
+	}
+
+	void observe(double jd, const eci_pos_t& obj, observer_view_t& out) const {
+		double theta = to_gmst(jd);
+
+		observe(sidereal_t{ theta, std::sin(theta), std::cos(theta) }, obj, out);
+	}
+
+	void observe(const sidereal_t& gst, const eci_pos_t& obj, observer_view_t& out) const;
+
+	// count states, obj[k] at sidereal angle gst[k] seen in out[k]
+	void observe(const sidereal_t* gst, const eci_pos_t* obj, size_t count, observer_view_t* out) const;
+
+	// same angles as observer_t::get_lookup_angle from site i
+	topocentric_t look_angle(const observer_view_t& view, size_t i) const;
+
+	// out[i] : look angles of obj from site i, all the sites pay for the angles
+	void get_lookup_angles(const sidereal_t& gst, const eci_pos_t& obj, observer_view_t& view, topocentric_t* out) const;
+
+private:
+	std::vector<geodetic_t> geo_;
+
+	// earth fixed position of the sites (km)
+	std::vector<double> x_, y_, z_;
+
+	// rows of the local frame : zenith, then south and east (z term 0) for the azimuth
+	std::vector<double> zx_, zy_, zz_;
+	std::vector<double> sx_, sy_, sz_;
+	std::vector<double> ex_, ey_;
 };
 
 struct line_pair {
@@ -281,10 +500,93 @@ using tle_map_list = std::map<std::string, line_pair>;
 
 tle_map_list load_tle_file(const std::string& filename);
 void parse_tle_lines(const line_pair& tle_data, char opsmode, gravconsttype whichconst, elsetrec& satrec);
-eci_pos_t get_sat_pos(double t_since, elsetrec& satrec);
 
-int get_orbit_num(double jd, const elsetrec& satrec);
+// FNV-1a hash of both lines : changes with any element of the set
+uint64_t tle_hash(const line_pair& tle_data);
+
+// Initialized satellite shared between the map, the Doppler and the predictions,
+// each of them propagates it with its own sgp4_state
+using sat_model_ptr = std::shared_ptr<const sgp4_model>;
+
+sat_model_ptr make_sat_model(const elsetrec& satrec);
+
+inline double epoch_jd(const sgp4_model& model) {
+	return model.meta.jdsatepoch + model.meta.jdsatepochF;
+}
+
+eci_pos_t get_sat_pos(double t_since, const sgp4_model& model, sgp4_state& state);
+
+int get_orbit_num(double jd, const sgp4_model& model);
+
+std::tuple<double, double> calc_azm_elev(double jd, const observer_t& observer, const sgp4_model& model, sgp4_state& state);
+double calc_elev(double jd, const observer_t& observer, const sgp4_model& model, sgp4_state& state);
+double regula_falsi(double xg, double xd, const observer_t& observer, const sgp4_model& model, sgp4_state& state);
+
+// Position of one satellite seen from one observer, by date. The last evaluations are
+// cached : the searches of one pass (crossings, culmination, look angles at the found
+// dates) share them and only propagate dates they have not seen yet
+class elevation_eval_t {
+public:
+	static constexpr size_t cache_size = 8;
+
+	elevation_eval_t(const sgp4_model& model, const observer_t& observer)
+		: model_(model)
+		, observer_(observer) {
+	}
+
+	// sine of the elevation at jd, 0 when the propagation fails (see error())
+	double sin_elevation(double jd);
+
+	topocentric_t look(double jd);
+
+	// elsetrec::error of the last propagation
+	int error() const {
+		return state_.error;
+	}
+
+	// propagations so far
+	size_t evaluations() const {
+		return evaluations_;
+	}
+
+private:
+	struct entry_t {
+		double jd;
+		eci_pos_t pos;
+		double sin_elevation;
+	};
+
+	const entry_t& _eval(double jd);
+
+	const sgp4_model& model_;
+	const observer_t& observer_;
+	sgp4_state state_{};
+
+	entry_t cache_[cache_size]{};
+	size_t used_{};
+	size_t evaluations_{};
+};
+
+struct crossing_t {
+	double jd;			// -1.0 when the propagation failed
+	size_t evaluations;	// propagations of the search
+};
+
+// date in [jd_a, jd_b] where the elevation crosses threshold (rad), within tol (day).
+// sin_a and sin_b are the elevation sines at both ends, already known by the caller,
+// on both sides of sin(threshold). Illinois variant of the regula falsi : the end
+// which stays in place has its value halved, so the bracket shrinks from both sides
+crossing_t find_crossing(elevation_eval_t& eval, double jd_a, double sin_a, double jd_b, double sin_b,
+	double threshold = 0.0, double tol = 1e-7);
+
+struct culmination_t {
+	double jd;				// -1.0 when the propagation failed
+	double sin_elevation;
+	size_t evaluations;		// propagations of the search
+};
 
-std::tuple<double, double> calc_azm_elev(double jd, observer_t& observer, elsetrec& satrec);
-double calc_elev(double jd, observer_t& observer, elsetrec& satrec);
-double regula_falsi(double xg, double xd, observer_t& observer, elsetrec& satrec);
+// date of the highest elevation between jd_a and jd_b, within tol (day). Brent search :
+// parabolic interpolation through the three best points, golden section steps when the
+// parabola is not trusted. The elevation near the top is nearly a parabola, a few
+// propagations are enough
+culmination_t find_culmination(elevation_eval_t& eval, double jd_a, double jd_b, double tol = 0.1 / 86400.0);
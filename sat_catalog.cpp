@@ -0,0 +1,86 @@
+#include "sat_catalog.h"
+
+#include <chrono>
+#include <exception>
+
+void sat_catalog_t::clear() {
+	names_.clear();
+	models_.clear();
+	hashes_.clear();
+	index_.clear();
+	failures_.clear();
+	load_ms_ = 0.0;
+}
+
+size_t sat_catalog_t::load(const std::vector<std::string>& filenames, thread_pool_t& pool, char opsmode, gravconsttype whichconst) {
+	clear();
+
+	auto start = std::chrono::steady_clock::now();
+
+	// one file per job
+	std::vector<tle_map_list> lists(filenames.size());
+	pool.parallel_for(filenames.size(), [&](size_t begin, size_t end) {
+		for (size_t f = begin; f < end; f++) {
+			lists[f] = load_tle_file(filenames[f]);
+		}
+	});
+
+	struct entry_t {
+		size_t file;
+		const std::string* name;
+		const line_pair* tle;
+	};
+
+	std::vector<entry_t> entries;
+	for (size_t f = 0; f < lists.size(); f++) {
+		for (auto& [name, tle] : lists[f]) {
+			entries.push_back(entry_t{ f, &name, &tle });
+		}
+	}
+
+	// every satellite is initialized in its own slot, no lock needed
+	std::vector<sgp4_model> models(entries.size());
+	std::vector<int> errors(entries.size());
+	pool.parallel_for(entries.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			elsetrec satrec{};
+			try {
+				parse_tle_lines(*entries[i].tle, opsmode, whichconst, satrec);
+			}
+			catch (const std::exception&) {
+				errors[i] = parse_error;
+				continue;
+			}
+
+			errors[i] = satrec.error;
+			if (satrec.error == 0)
+				SGP4Funcs::makesgp4model(satrec, models[i]);
+		}
+	}, 64);
+
+	names_.reserve(entries.size());
+	models_.reserve(entries.size());
+	hashes_.reserve(entries.size());
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (errors[i] != 0) {
+			failures_.push_back(failure_t{ filenames[entries[i].file], *entries[i].name, errors[i] });
+			continue;
+		}
+
+		index_.emplace(*entries[i].name, models_.size());
+		names_.push_back(*entries[i].name);
+		models_.push_back(std::move(models[i]));
+		hashes_.push_back(tle_hash(*entries[i].tle));
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	load_ms_ = elapsed.count();
+
+	return models_.size();
+}
+
+size_t sat_catalog_t::find(const std::string& name) const {
+	auto it = index_.find(name);
+
+	return it == index_.end() ? npos : it->second;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include "sat_calc.h"
+#include "thread_pool.h"
+
+// Satellites of one or several tle files, parsed and initialized in parallel.
+// The ready models are stored contiguously, in the order of the files and, inside a
+// file, of the names. Satellites sgp4init rejects are left out and reported in failures().
+class sat_catalog_t {
+public:
+	static constexpr size_t npos = (size_t)-1;
+	static constexpr int parse_error = 8;	// custom : malformed tle lines
+
+	struct failure_t {
+		std::string file;
+		std::string name;
+		int error;	// elsetrec::error of sgp4init, or parse_error
+	};
+
+	sat_catalog_t() = default;
+
+	void clear();
+
+	// returns the number of ready models, files which cannot be opened are ignored
+	size_t load(const std::vector<std::string>& filenames, thread_pool_t& pool,
+		char opsmode = 'a', gravconsttype whichconst = wgs72);
+
+	size_t size() const {
+		return models_.size();
+	}
+
+	bool empty() const {
+		return models_.empty();
+	}
+
+	const std::string& name(size_t i) const {
+		return names_[i];
+	}
+
+	const sgp4_model& model(size_t i) const {
+		return models_[i];
+	}
+
+	// tle_hash() of the lines of satellite i
+	uint64_t hash(size_t i) const {
+		return hashes_[i];
+	}
+
+	const std::vector<sgp4_model>& models() const {
+		return models_;
+	}
+
+	// index of the satellite, npos if it is not in the catalog
+	size_t find(const std::string& name) const;
+
+	const std::vector<failure_t>& failures() const {
+		return failures_;
+	}
+
+	// wall time of the last load, files reading included (ms)
+	double load_ms() const {
+		return load_ms_;
+	}
+
+private:
+	std::vector<std::string> names_;
+	std::vector<sgp4_model> models_;
+	std::vector<uint64_t> hashes_;
+	std::unordered_map<std::string, size_t> index_;	// first satellite of each name
+
+	std::vector<failure_t> failures_;
+	double load_ms_{};
+};
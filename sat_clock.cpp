@@ -0,0 +1,67 @@
+#include "sat_clock.h"
+#include "sat_calc.h"
+
+sat_clock_t& sat_clock_t::shared() {
+	static sat_clock_t clock;
+
+	return clock;
+}
+
+double sat_clock_t::now() const {
+	double wall = julian_now();
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return _now(wall);
+}
+
+void sat_clock_t::reset() {
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	date_ = 0.0;
+	wall_ = 0.0;
+	scale_ = 1.0;
+}
+
+double sat_clock_t::offset() const {
+	double wall = julian_now();
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return _now(wall) - wall;
+}
+
+void sat_clock_t::set_offset(double days) {
+	double wall = julian_now();
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	date_ = wall + days;
+	wall_ = wall;
+}
+
+double sat_clock_t::scale() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return scale_;
+}
+
+void sat_clock_t::set_scale(double scale) {
+	double wall = julian_now();
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	date_ = _now(wall);
+	wall_ = wall;
+	scale_ = scale;
+}
+
+void sat_clock_t::set_date(double jd) {
+	double wall = julian_now();
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	date_ = jd;
+	wall_ = wall;
+}
+
+void sat_clock_t::advance(double days) {
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	date_ += days;
+}
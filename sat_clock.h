@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+// Date used by the tracking, the Doppler correction and the predictions (julian date).
+// Follows the system clock by default, with a settable offset, and can run scaled
+// (fast forward, slow motion), frozen (scale 0) or be stepped by hand, so replays and
+// benchmarks drive the plugin without waiting on the wall time.
+// The date stays continuous when the scale or the offset change.
+class sat_clock_t {
+public:
+	sat_clock_t() = default;
+
+	sat_clock_t(const sat_clock_t&) = delete;
+	sat_clock_t& operator=(const sat_clock_t&) = delete;
+
+	// clock of the plugin
+	static sat_clock_t& shared();
+
+	double now() const;
+
+	// back to the system clock
+	void reset();
+
+	// date - system clock (day)
+	double offset() const;
+	void set_offset(double days);
+
+	// days of the clock per day of the system clock, 0 freezes it
+	double scale() const;
+	void set_scale(double scale);
+
+	// jumps to jd, then runs at the current scale
+	void set_date(double jd);
+
+	// moves the date by days, mostly for a frozen clock
+	void advance(double days);
+
+private:
+	// caller holds mutex_
+	double _now(double wall) const {
+		return date_ + scale_ * (wall - wall_);
+	}
+
+	// date_ at wall_, then scale_ days per day
+	double date_{};
+	double wall_{};
+	double scale_{ 1.0 };
+
+	mutable std::mutex mutex_;
+};
+
+// julian date to a system clock time point, for std::chrono formatting
+inline std::chrono::system_clock::time_point to_time_point(double jd) {
+	constexpr double jan_1970 = 2440587.5;
+	std::chrono::duration<double> since_1970((jd - jan_1970) * 86400.0);
+
+	return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(since_1970));
+}
@@ -0,0 +1,178 @@
+#include "sat_ephemeris.h"
+#include "sgp4_batch.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+	constexpr double kepler_noise = 1e-12;	// relative, see _fit
+
+	// sum of c[j] * T_j(x) for j = 0..order, with c[0] halved (Clenshaw recurrence)
+	inline double chebyshev_eval(const double* c, int order, double x) {
+		double b1 = 0.0, b2 = 0.0;
+		double x2 = 2.0 * x;
+		for (int j = order; j > 0; j--) {
+			double b0 = x2 * b1 - b2 + c[j];
+			b2 = b1;
+			b1 = b0;
+		}
+		return x * b1 - b2 + 0.5 * c[0];
+	}
+}
+
+void sat_ephemeris_t::clear() {
+	segments_.clear();
+	coefs_.clear();
+}
+
+bool sat_ephemeris_t::build(const sgp4_model& model, double jd_start, double jd_end, double tolerance_km, int order, int segs_per_rev,
+	std::stop_token stop) {
+	clear();
+
+	if (order < 1 || order > max_order)
+		return false;
+
+	epoch_ = epoch_jd(model);
+	order_ = order;
+	tolerance_km_ = tolerance_km;
+
+	double period = 2.0 * M_PI / model.meta.no_kozai;	// (min)
+	double seg_len = period / (double)segs_per_rev;
+
+	double t = (jd_start - epoch_) * 1440.0;
+	double t_end = (jd_end - epoch_) * 1440.0;
+	while (t < t_end) {
+		if (stop.stop_requested())
+			return false;
+
+		double len = std::min(seg_len, t_end - t);
+		if (!_fit(model, t, len, 0))
+			return false;
+
+		t += len;
+	}
+
+	return true;
+}
+
+bool sat_ephemeris_t::_fit(const sgp4_model& model, double t, double len, int depth) {
+	const int n = order_ + 1;		// chebyshev nodes
+	const int m = 2 * n + 1;		// check points, both ends included
+
+	double mid = t + len / 2.0;
+	double half = len / 2.0;
+
+	double times[3 * (max_order + 1) + 1];	// nodes, then check points
+
+	for (int k = 0; k < n; k++) {
+		times[k] = mid + half * std::cos(M_PI * (k + 0.5) / n);
+	}
+	for (int k = 0; k < m; k++) {
+		times[n + k] = t + len * (double)k / (double)(m - 1);
+	}
+
+	sgp4_batch_result_t res;
+	sgp4_batch_t::propagate_minutes(model, times, n + m, res);
+	for (int k = 0; k < n + m; k++) {
+		if (res.error[k] != 0)
+			return false;
+	}
+
+	const std::vector<double>* samples[6] = { &res.x, &res.y, &res.z, &res.vx, &res.vy, &res.vz };
+
+	double c[6][max_order + 1];
+	for (int i = 0; i < 6; i++) {
+		for (int j = 0; j < n; j++) {
+			double sum = 0.0;
+			for (int k = 0; k < n; k++) {
+				sum += (*samples[i])[k] * std::cos(M_PI * j * (k + 0.5) / n);
+			}
+			c[i][j] = 2.0 * sum / n;
+		}
+	}
+
+	double max_err = 0.0, max_vel_err = 0.0, max_r = 0.0, max_v = 0.0;
+	for (int k = 0; k < m; k++) {
+		double x = (times[n + k] - mid) / half;
+		double dp = 0.0, dv = 0.0;
+		for (int i = 0; i < 3; i++) {
+			dp += sqr(chebyshev_eval(c[i], order_, x) - (*samples[i])[n + k]);
+			dv += sqr(chebyshev_eval(c[i + 3], order_, x) - (*samples[i + 3])[n + k]);
+		}
+		max_err = std::max(max_err, std::sqrt(dp));
+		max_vel_err = std::max(max_vel_err, std::sqrt(dv));
+		max_r = std::max(max_r, std::sqrt(sqr((*samples[0])[n + k]) + sqr((*samples[1])[n + k]) + sqr((*samples[2])[n + k])));
+		max_v = std::max(max_v, std::sqrt(sqr((*samples[3])[n + k]) + sqr((*samples[4])[n + k]) + sqr((*samples[5])[n + k])));
+	}
+
+	// between the check points the error can exceed what they measured : the margin is
+	// the size of the last two coefficients, which bounds the terms the fit left out
+	// while the series converges, plus the noise of sgp4 itself, whose kepler equation
+	// is solved to 1e-12 rad
+	double tail = 0.0, vel_tail = 0.0;
+	for (int i = 0; i < 3; i++) {
+		tail += sqr(std::fabs(c[i][order_ - 1]) + std::fabs(c[i][order_]));
+		vel_tail += sqr(std::fabs(c[i + 3][order_ - 1]) + std::fabs(c[i + 3][order_]));
+	}
+	max_err += std::sqrt(tail) + kepler_noise * max_r;
+	max_vel_err += std::sqrt(vel_tail) + kepler_noise * max_v;
+
+	if (max_err > tolerance_km_ && depth < max_split_depth) {
+		return _fit(model, t, half, depth + 1) && _fit(model, mid, half, depth + 1);
+	}
+
+	segments_.push_back(segment_t{ t, t + len, max_err, max_vel_err, coefs_.size(), max_err <= tolerance_km_ });
+	for (int i = 0; i < 6; i++) {
+		coefs_.insert(coefs_.end(), c[i], c[i] + n);
+	}
+
+	return true;
+}
+
+const sat_ephemeris_t::segment_t* sat_ephemeris_t::segment(double jd) const {
+	if (!covers(jd))
+		return nullptr;
+
+	double t = (jd - epoch_) * 1440.0;
+
+	auto it = std::upper_bound(segments_.begin(), segments_.end(), t, [](double ts, const segment_t& s) {
+		return ts < s.t_start;
+	});
+
+	return &*(it == segments_.begin() ? it : it - 1);
+}
+
+bool sat_ephemeris_t::get_pos(double jd, eci_pos_t& pos) const {
+	const segment_t* s = segment(jd);
+	if (!s || !s->within_tolerance)
+		return false;
+
+	const segment_t& seg = *s;
+	double t = (jd - epoch_) * 1440.0;
+
+	double half = (seg.t_end - seg.t_start) / 2.0;
+	double x = (t - (seg.t_start + half)) / half;
+
+	const int n = order_ + 1;
+	const double* c = &coefs_[seg.coef];
+
+	pos.pos.set(chebyshev_eval(c, order_, x), chebyshev_eval(c + n, order_, x), chebyshev_eval(c + 2 * n, order_, x));
+	pos.vel.set(chebyshev_eval(c + 3 * n, order_, x), chebyshev_eval(c + 4 * n, order_, x), chebyshev_eval(c + 5 * n, order_, x));
+
+	return true;
+}
+
+size_t sat_ephemeris_t::above_tolerance() const {
+	return (size_t)std::count_if(segments_.begin(), segments_.end(), [](const segment_t& seg) {
+		return !seg.within_tolerance;
+	});
+}
+
+double sat_ephemeris_t::max_error_km() const {
+	double err = 0.0;
+	for (auto& seg : segments_) {
+		err = std::max(err, seg.max_error_km);
+	}
+	return err;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <stop_token>
+#include <cstddef>
+
+#include "sat_calc.h"
+
+// Piecewise Chebyshev approximation of the sgp4 positions and velocities of one
+// satellite over a time window. Each segment is fitted on its Chebyshev nodes, then
+// checked against sgp4 on a denser grid. The error estimate kept with the segment is
+// the max error on that grid plus the last two coefficients and the noise of sgp4 :
+// an estimate, not a guaranteed bound (sat_bench compares it with sgp4 at random
+// times). Segments above the tolerance are split in two, those still above it after
+// max_split_depth splits are kept but flagged, get_pos refuses them.
+// Times are kept in minutes since the satellite epoch, like the sgp4 inputs, so that
+// the fit is not limited by the resolution of julian dates.
+// Once built the ephemeris is read only and can be shared between threads.
+class sat_ephemeris_t {
+public:
+	static constexpr int default_order = 10;		// degree of the polynomials
+	static constexpr int max_order = 31;
+	static constexpr int default_segs_per_rev = 4;	// initial segments per orbital period
+	static constexpr int max_split_depth = 6;		// a segment is split at most 6 times
+
+	struct segment_t {
+		double t_start;				// minutes since epoch
+		double t_end;
+		double max_error_km;		// position error estimate
+		double max_vel_error_kms;	// velocity error estimate
+		size_t coef;				// first coefficient in coefs_
+		bool within_tolerance;		// false : max_split_depth reached above the tolerance
+	};
+
+	sat_ephemeris_t() = default;
+
+	// fit the window [jd_start, jd_end], returns false if sgp4 fails before jd_end or
+	// stop is requested : the ephemeris then stops at the last valid segment. order is
+	// at most max_order
+	bool build(const sgp4_model& model, double jd_start, double jd_end, double tolerance_km = 0.001,
+		int order = default_order, int segs_per_rev = default_segs_per_rev, std::stop_token stop = {});
+
+	void clear();
+
+	bool covers(double jd) const {
+		double t = (jd - epoch_) * 1440.0;
+		return !segments_.empty() && t >= segments_.front().t_start && t <= segments_.back().t_end;
+	}
+
+	// position (km) and velocity (km/s) at jd, false if jd is outside the window or
+	// in a segment above the tolerance : the caller propagates with sgp4 there
+	bool get_pos(double jd, eci_pos_t& pos) const;
+
+	// segment covering jd, nullptr outside the window
+	const segment_t* segment(double jd) const;
+
+	double jd_start() const {
+		return segments_.empty() ? 0.0 : epoch_ + segments_.front().t_start / 1440.0;
+	}
+
+	double jd_end() const {
+		return segments_.empty() ? 0.0 : epoch_ + segments_.back().t_end / 1440.0;
+	}
+
+	double tolerance_km() const {
+		return tolerance_km_;
+	}
+
+	// largest error estimate of all the segments
+	double max_error_km() const;
+
+	// segments kept above the tolerance
+	size_t above_tolerance() const;
+
+	const std::vector<segment_t>& segments() const {
+		return segments_;
+	}
+
+private:
+	// fit [t, t + len] (minutes since epoch), split it when the error is above the tolerance
+	bool _fit(const sgp4_model& model, double t, double len, int depth);
+
+	double epoch_{};	// julian date of the satellite epoch
+	int order_{ default_order };
+	double tolerance_km_{};
+
+	std::vector<segment_t> segments_;
+	std::vector<double> coefs_;	// 6 * (order_ + 1) per segment : x, y, z, vx, vy, vz
+};
@@ -7,6 +7,7 @@
 
 #define TLE_LIST	"celestrak_legacy.json"
 #define CONFIG_FILE	"satrack_config.json"
+#define PASS_CACHE_FILE	"satrack_passes.bin"
 
 struct tle_list_line_t {
 	std::string url;
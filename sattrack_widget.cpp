@@ -43,7 +43,10 @@ namespace drawerbase {
 			nana::paint::image img_;
 
 			std::string sat_name{ };
-			elsetrec gt_satrec_{};
+			sat_model_ptr gt_model_{};
+			sgp4_batch_result_t gt_track_{};
+			double gt_gmst_[n_segs_ground_track]{};
+			geodetic_soa_t gt_geo_{};
 
 			std::string site_name;
 			observer_t observer_{};
@@ -125,10 +128,10 @@ namespace drawerbase {
 				observer_ = obs;
 			}
 
-			void set_satellite(const std::string& satname, const elsetrec& satrec) {
+			void set_satellite(const std::string& satname, const sat_model_ptr& model) {
 				orbit_time_ = -1.0;
 				sat_name = satname;
-				gt_satrec_ = satrec;
+				gt_model_ = model;
 			}
 
 			void set_downlink_freq(double f) {
@@ -223,7 +226,7 @@ namespace drawerbase {
 					break;
 				}
 
-				std::chrono::zoned_time now{ std::chrono::current_zone(), std::chrono::system_clock::now() };
+				std::chrono::zoned_time now{ std::chrono::current_zone(), to_time_point(current_jd_) };
 				s = std::format("{:%d-%m-%Y %H:%M:%OS}", now);
 				graph.string(nana::point{ (int)(margin_left + (map_type == e_map_type::small_size ? 0.73 : 0.78) * world_size.width), text_pos }, s, nana::colors::white);
 
@@ -396,36 +399,40 @@ namespace drawerbase {
 
 			void _calc_ground_track() {
 
-				if (gt_satrec_.error)
+				if (!gt_model_)
 					return;
 
 				double jd = current_jd_;
-				double epochMeanMotion = gt_satrec_.no_kozai * 1440 / (2.0 * M_PI);			// (rev/day)
+				double epochMeanMotion = gt_model_->meta.no_kozai * 1440 / (2.0 * M_PI);			// (rev/day)
 
 				if (jd - orbit_time_ > 1.0 / epochMeanMotion || orbit_time_ < 0.0) {
 
 					orbit_time_ = jd;
 
-					double tle_date = gt_satrec_.jdsatepoch + gt_satrec_.jdsatepochF;
-					double tmpTime = (tle_date > jd) ? tle_date : jd - (1.0 / epochMeanMotion) / 20.0;
+					double tle_date = epoch_jd(*gt_model_);
+					double startTime = (tle_date > jd) ? tle_date : jd - (1.0 / epochMeanMotion) / 20.0;
+					double stepTime = (1.0 / epochMeanMotion) / (double)n_segs_per_rev;
+
+					sgp4_batch_t::propagate_grid(*gt_model_, startTime, stepTime, n_segs_ground_track, gt_track_);
+					sidereal_grid_t gst(startTime, stepTime);
 
 					for (int k = 0; k < n_segs_ground_track; k++) {
+						gt_gmst_[k] = gst.current().theta;
+						gst.next();
+					}
+					to_geodetic(gt_track_.x.data(), gt_track_.y.data(), gt_track_.z.data(), gt_gmst_, n_segs_ground_track, gt_geo_);
 
-						eci_pos_t sat = get_sat_pos((tmpTime - tle_date) * 1440, gt_satrec_);
-						if (gt_satrec_.error != 0)
-							return;
+					for (int k = 0; k < n_segs_ground_track; k++) {
 
-						topocentric_t topo = observer_.get_lookup_angle(tmpTime, sat);
-						geodetic_t geo(tmpTime, sat);
+						if (gt_track_.error[k] != 0)
+							return;
 
-						ground_track_[k].x1 = (short)((180.0 + to_deg(geo.lon)) * grid_scale_x + margin_left - 0.5);
-						ground_track_[k].y1 = (short)((90.0 - to_deg(geo.lat)) * grid_scale_y + margin_top - 0.5);
+						ground_track_[k].x1 = (short)((180.0 + to_deg(gt_geo_.lon[k])) * grid_scale_x + margin_left - 0.5);
+						ground_track_[k].y1 = (short)((90.0 - to_deg(gt_geo_.lat[k])) * grid_scale_y + margin_top - 0.5);
 						if (k > 0) {
 							ground_track_[k - 1].x2 = ground_track_[k].x1;
 							ground_track_[k - 1].y2 = ground_track_[k].y1;
 						}
-
-						tmpTime += (1.0 / epochMeanMotion) / (double)n_segs_per_rev;
 					}
 
 					ground_track_[n_segs_ground_track - 1].x2 = ground_track_[n_segs_ground_track - 1].x1;
@@ -474,6 +481,9 @@ sattrack_widget::sattrack_widget(nana::window wd, const std::string& maps_path,
 
 sattrack_widget::~sattrack_widget() {
 	stop();
+
+	// the futures wait for the fits, stopped at their next segment
+	ephem_stop_.request_stop();
 }
 
 nana::size sattrack_widget::calc_window_size(e_map_type mt) {
@@ -499,12 +509,22 @@ void sattrack_widget::set_map(e_map_type mt, const std::string& maps_path) {
 	size(calc_window_size(mt));
 }
 
-void sattrack_widget::set_satellite(const std::string& satname, const elsetrec& satrec) {
-	satrec_ = satrec;
+void sattrack_widget::set_satellite(const std::string& satname, const sat_model_ptr& model) {
+	model_ = model;
+	state_ = sgp4_state{};
+
+	// a fit of the previous satellite still running is stopped, not waited for
+	if (ephem_build_.valid()) {
+		ephem_stop_.request_stop();
+		ephem_retired_.push_back(std::move(ephem_build_));
+	}
+	_drop_retired();
+	ephem_.reset();
+	ephem_until_ = 0.0;
 
 	nana::internal_scope_guard lock;
 
-	get_drawer_trigger().impl()->set_satellite(satname, satrec_);
+	get_drawer_trigger().impl()->set_satellite(satname, model_);
 }
 
 void sattrack_widget::set_site(const std::string& sitename, double lat, double lng, double ht) {
@@ -536,27 +556,85 @@ void sattrack_widget::stop() {
 double sattrack_widget::get_doppler_correction_hz() {
 	nana::internal_scope_guard lock;
 
-	return (topo_.elevation > 0.0) ? downlinkFreq * (1.0 - topo_.range_rate / CVAC) : downlinkFreq;
+	if (!model_ || state_.error != 0)
+		return downlinkFreq;
+
+	double jd = clock_->now();
+
+	eci_pos_t sat;
+	if (!_sat_pos(jd, sat))
+		return downlinkFreq;
+
+	topocentric_t topo = observer_.get_lookup_angle(jd, sat);
+
+	return (topo.elevation > 0.0) ? downlinkFreq * (1.0 - topo.range_rate / CVAC) : downlinkFreq;
+}
+
+void sattrack_widget::set_clock(const sat_clock_t& clock) {
+	clock_ = &clock;
+	_calc_pos();
 }
 
 void sattrack_widget::_calc_pos() {
-	if (satrec_.error != 0)
+	if (!model_ || state_.error != 0)
 		return;
 
-	double jd = julian_now();
-	double t_since = (jd - (satrec_.jdsatepoch + satrec_.jdsatepochF)) * 1440;
+	double jd = clock_->now();
 
-	sat_ = get_sat_pos(t_since, satrec_);
-	if (satrec_.error != 0)
+	_update_ephemeris(jd);
+
+	if (!_sat_pos(jd, sat_))
 		return;
 
 	topo_ = observer_.get_lookup_angle(jd, sat_);
 	geo_.update(jd, sat_);
 
-	int orbit_num = get_orbit_num(jd, satrec_);
+	int orbit_num = get_orbit_num(jd, *model_);
 
 	nana::internal_scope_guard lock;
 
 	get_drawer_trigger().impl()->update_state(jd, orbit_num, topo_, geo_);
 }
 
+bool sattrack_widget::_sat_pos(double jd, eci_pos_t& sat) {
+	if (ephem_ && ephem_->get_pos(jd, sat))
+		return true;
+
+	sat = get_sat_pos((jd - epoch_jd(*model_)) * 1440, *model_, state_);
+
+	return state_.error == 0;
+}
+
+void sattrack_widget::_update_ephemeris(double jd) {
+	using namespace std::chrono_literals;
+
+	_drop_retired();
+
+	if (ephem_build_.valid() && ephem_build_.wait_for(0s) == std::future_status::ready)
+		ephem_ = ephem_build_.get();
+
+	if (ephem_build_.valid() || jd + ephemeris_margin < ephem_until_)
+		return;
+
+	// the model is immutable, the fit runs on its own thread without a copy
+	sat_model_ptr model = model_;
+	double jd_start = jd;
+	ephem_until_ = jd + ephemeris_window;
+	ephem_stop_ = std::stop_source{};
+
+	ephem_build_ = std::async(std::launch::async, [model, jd_start, jd_end = ephem_until_, stop = ephem_stop_.get_token()]() {
+		auto ephem = std::make_shared<sat_ephemeris_t>();
+		ephem->build(*model, jd_start, jd_end, ephemeris_tolerance_km, sat_ephemeris_t::default_order,
+			sat_ephemeris_t::default_segs_per_rev, stop);
+
+		return ephemeris_ptr(ephem);
+	});
+}
+
+void sattrack_widget::_drop_retired() {
+	using namespace std::chrono_literals;
+
+	std::erase_if(ephem_retired_, [](const std::future<ephemeris_ptr>& fit) {
+		return fit.wait_for(0s) == std::future_status::ready;
+	});
+}
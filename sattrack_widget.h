@@ -8,8 +8,14 @@
 #include <nana/gui/widgets/picture.hpp>
 #include <nana/paint/pixel_buffer.hpp>
 #include <nana/gui/timer.hpp>
+#include <future>
+#include <vector>
+#include <stop_token>
 
 #include "sat_calc.h"
+#include "sgp4_batch.h"
+#include "sat_ephemeris.h"
+#include "sat_clock.h"
 
 class sattrack_widget;
 
@@ -59,14 +65,19 @@ public:
 
 	void set_map(e_map_type mt, const std::string& maps_path);
 
-	void set_satellite(const std::string& satname, const elsetrec& satrec);
+	// the model is shared with the map renderer, it is never copied
+	void set_satellite(const std::string& satname, const sat_model_ptr& model);
 
 	void set_site(const std::string& sitename, double lat, double lng, double ht);
 
 	void set_downlink_freq(double f);
 
+	// evaluated at the date of the call, not at the last map update
 	double get_doppler_correction_hz();
 
+	// date source of the tracking, the shared clock by default
+	void set_clock(const sat_clock_t& clock);
+
 	void start();
 	void stop();
 
@@ -75,6 +86,20 @@ private:
 
 	void _calc_pos();
 
+	// position at jd, from the ephemeris when it covers jd
+	bool _sat_pos(double jd, eci_pos_t& sat);
+
+	// the current position is read from a chebyshev ephemeris, fitted in the
+	// background over the next day and refitted before it runs out
+	static constexpr double ephemeris_window = 1.0;			// (day)
+	static constexpr double ephemeris_margin = 1.0 / 24.0;	// refit one hour before the end (day)
+	static constexpr double ephemeris_tolerance_km = 0.001;
+
+	using ephemeris_ptr = std::shared_ptr<const sat_ephemeris_t>;
+
+	void _update_ephemeris(double jd);
+	void _drop_retired();
+
 	void _on_timer() {
 		_calc_pos();
 		nana::API::refresh_window(*this);
@@ -82,7 +107,19 @@ private:
 
 	double downlinkFreq{ 137.100000 * 1000000.0 };
 
-	elsetrec satrec_{};
+	const sat_clock_t* clock_{ &sat_clock_t::shared() };
+
+	sat_model_ptr model_{};
+	sgp4_state state_{};
+
+	ephemeris_ptr ephem_{};
+	std::future<ephemeris_ptr> ephem_build_{};
+	std::stop_source ephem_stop_{};	// of the fit of ephem_build_
+
+	// fits of the former satellites, stopped and dropped once they returned : the
+	// destructor of a std::async future waits for its thread
+	std::vector<std::future<ephemeris_ptr>> ephem_retired_{};
+	double ephem_until_{};	// end of the last requested window
 	observer_t observer_{};
 	eci_pos_t sat_{};
 	topocentric_t topo_{};
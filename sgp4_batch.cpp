@@ -0,0 +1,511 @@
+#include "sgp4_batch.h"
+
+#include <cmath>
+#include <algorithm>
+
+// SSE2 is part of x64, and the default of the 32 bits msvc target
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SGP4_BATCH_SSE2
+#endif
+
+namespace {
+
+	constexpr double twopi = 2.0 * 3.14159265358979323846;
+
+	// newton iterations for kepler's equation : a block stops once its lanes all moved
+	// by less than 1e-12 rad, or after 10 iterations, as sgp4 does for one satellite
+	constexpr int kepler_iterations = 10;
+	constexpr double kepler_tolerance = 1.0e-12;
+
+	// fmod(x, 2pi) without a library call so the lane loops stay vectorizable
+	inline double fmod_twopi(double x) {
+		return x - twopi * std::trunc(x / twopi);
+	}
+
+	// sin and cos of x = q pi/2 + r, |r| <= pi/4 : pi/2 in three parts so that q pi/2 is
+	// exact for |q| < 2^29, and the cephes polynomials of sin and cos over [-pi/4, pi/4]
+	constexpr double two_over_pi = 0.63661977236758134308;
+	constexpr double pio2_1 = 1.57079625129699707031e0;
+	constexpr double pio2_2 = 7.54978941586159635335e-8;
+	constexpr double pio2_3 = 5.39030285815811905290e-15;
+
+	constexpr double sin_c[] = { 1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+		-1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1 };
+	constexpr double cos_c[] = { -1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+		2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2 };
+
+	inline void sincos_poly(double x, double& s, double& c) {
+		double q = std::nearbyint(x * two_over_pi);
+		double r = ((x - q * pio2_1) - q * pio2_2) - q * pio2_3;
+		double z = r * r;
+
+		double ps = ((((sin_c[0] * z + sin_c[1]) * z + sin_c[2]) * z + sin_c[3]) * z + sin_c[4]) * z + sin_c[5];
+		double pc = ((((cos_c[0] * z + cos_c[1]) * z + cos_c[2]) * z + cos_c[3]) * z + cos_c[4]) * z + cos_c[5];
+		double sr = r + r * z * ps;
+		double cr = 1.0 - 0.5 * z + z * z * pc;
+
+		long long n = (long long)q;
+		s = (n & 1) ? cr : sr;
+		c = (n & 1) ? sr : cr;
+		s = (n & 2) ? -s : s;
+		c = ((n + 1) & 2) ? -c : c;
+	}
+
+	// sin and cos of the SGP4_BATCH_LANES lanes of x
+	void sincos_lanes(const double* x, double* s, double* c) {
+#ifdef SGP4_BATCH_SSE2
+		const __m128d k_two_over_pi = _mm_set1_pd(two_over_pi);
+		const __m128d k_pio2_1 = _mm_set1_pd(pio2_1);
+		const __m128d k_pio2_2 = _mm_set1_pd(pio2_2);
+		const __m128d k_pio2_3 = _mm_set1_pd(pio2_3);
+		const __m128d one = _mm_set1_pd(1.0);
+		const __m128d half = _mm_set1_pd(0.5);
+		const __m128i bit0 = _mm_set1_epi32(1);
+		const __m128i bit1 = _mm_set1_epi64x(2);
+
+		for (int l = 0; l < SGP4_BATCH_LANES; l += 2) {
+			__m128d vx = _mm_loadu_pd(x + l);
+
+			// quadrants rounded to nearest, each one copied to both halves of its 64 bits lane
+			__m128i qi = _mm_cvtpd_epi32(_mm_mul_pd(vx, k_two_over_pi));
+			__m128d q = _mm_cvtepi32_pd(qi);
+			qi = _mm_shuffle_epi32(qi, _MM_SHUFFLE(1, 1, 0, 0));
+
+			__m128d r = _mm_sub_pd(vx, _mm_mul_pd(q, k_pio2_1));
+			r = _mm_sub_pd(r, _mm_mul_pd(q, k_pio2_2));
+			r = _mm_sub_pd(r, _mm_mul_pd(q, k_pio2_3));
+			__m128d z = _mm_mul_pd(r, r);
+
+			__m128d ps = _mm_set1_pd(sin_c[0]);
+			__m128d pc = _mm_set1_pd(cos_c[0]);
+			for (int k = 1; k < 6; k++) {
+				ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(sin_c[k]));
+				pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(cos_c[k]));
+			}
+			__m128d sr = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), ps));
+			__m128d cr = _mm_add_pd(_mm_sub_pd(one, _mm_mul_pd(half, z)), _mm_mul_pd(_mm_mul_pd(z, z), pc));
+
+			// odd quadrants swap sin and cos, bit 1 of q (of q + 1 for cos) flips the sign
+			__m128d swap = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(qi, bit0), bit0));
+			__m128d vs = _mm_or_pd(_mm_and_pd(swap, cr), _mm_andnot_pd(swap, sr));
+			__m128d vc = _mm_or_pd(_mm_and_pd(swap, sr), _mm_andnot_pd(swap, cr));
+			__m128d sign_s = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(qi, bit1), 62));
+			__m128d sign_c = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(_mm_add_epi32(qi, bit0), bit1), 62));
+
+			_mm_storeu_pd(s + l, _mm_xor_pd(vs, sign_s));
+			_mm_storeu_pd(c + l, _mm_xor_pd(vc, sign_c));
+		}
+#else
+		for (int l = 0; l < SGP4_BATCH_LANES; l++) {
+			sincos_poly(x[l], s[l], c[l]);
+		}
+#endif
+	}
+}
+
+void sgp4_batch_t::near_soa_t::clear() {
+	for_each_field([](std::vector<double>& v) { v.clear(); });
+	lanes = 0;
+}
+
+void sgp4_batch_t::near_soa_t::reserve(size_t n) {
+	n = (n + SGP4_BATCH_LANES - 1) / SGP4_BATCH_LANES * SGP4_BATCH_LANES;
+
+	for_each_field([n](std::vector<double>& v) { v.reserve(n); });
+}
+
+template <class rec_t>
+void sgp4_batch_t::near_soa_t::push(const rec_t& satrec, double jd_epoch) {
+	// the terms only used when isimp != 1 are zeroed, so the kernel applies them unconditionally
+	bool simp = (satrec.isimp == 1);
+
+	std::pair<std::vector<double>*, double> fields[] = {
+		{ &jdepoch, jd_epoch },
+		{ &mo, satrec.mo }, { &mdot, satrec.mdot },
+		{ &argpo, satrec.argpo }, { &argpdot, satrec.argpdot },
+		{ &nodeo, satrec.nodeo }, { &nodedot, satrec.nodedot }, { &nodecf, satrec.nodecf },
+		{ &bstar, satrec.bstar }, { &cc1, satrec.cc1 }, { &cc4, satrec.cc4 },
+		{ &cc5, simp ? 0.0 : satrec.cc5 }, { &t2cof, satrec.t2cof },
+		{ &t3cof, simp ? 0.0 : satrec.t3cof }, { &t4cof, simp ? 0.0 : satrec.t4cof }, { &t5cof, simp ? 0.0 : satrec.t5cof },
+		{ &d2, simp ? 0.0 : satrec.d2 }, { &d3, simp ? 0.0 : satrec.d3 }, { &d4, simp ? 0.0 : satrec.d4 },
+		{ &omgcof, simp ? 0.0 : satrec.omgcof }, { &xmcof, simp ? 0.0 : satrec.xmcof },
+		{ &eta, satrec.eta }, { &delmo, satrec.delmo }, { &sinmao, satrec.sinmao },
+		{ &no_unkozai, satrec.no_unkozai }, { &ecco, satrec.ecco }, { &inclo, satrec.inclo },
+		{ &sinio, std::sin(satrec.inclo) }, { &cosio, std::cos(satrec.inclo) },
+		{ &aycof, satrec.aycof }, { &xlcof, satrec.xlcof },
+		{ &con41, satrec.con41 }, { &x1mth2, satrec.x1mth2 }, { &x7thm1, satrec.x7thm1 },
+		{ &xke, satrec.xke }, { &j2, satrec.j2 }, { &radiusearthkm, satrec.radiusearthkm },
+	};
+
+	size_t n = lanes;
+	for (auto& [v, value] : fields) {
+		// a new block is padded with copies of its first satellite so that
+		// the unused lanes always hold valid elements
+		if (n % SGP4_BATCH_LANES == 0)
+			v->resize(n + SGP4_BATCH_LANES, value);
+		else
+			(*v)[n] = value;
+	}
+
+	lanes++;
+}
+
+void sgp4_batch_t::clear() {
+	count_ = 0;
+
+	near_.clear();
+	near_index_.clear();
+
+	deep_.clear();
+	deep_state_.clear();
+	deep_index_.clear();
+}
+
+void sgp4_batch_t::reserve(size_t n) {
+	near_.reserve(n);
+	near_index_.reserve(n);
+}
+
+size_t sgp4_batch_t::add(const elsetrec& satrec) {
+	if (satrec.method == 'd') {
+		sgp4_model model;
+		SGP4Funcs::makesgp4model(satrec, model);
+
+		return add(model);
+	}
+
+	near_.push(satrec, satrec.jdsatepoch + satrec.jdsatepochF);
+	near_index_.push_back(count_);
+
+	return count_++;
+}
+
+size_t sgp4_batch_t::add(const sgp4_model& model) {
+	if (model.near.method == 'd') {
+		deep_.push_back(model);
+		deep_state_.push_back(sgp4_state{});
+		deep_index_.push_back(count_);
+	}
+	else {
+		near_.push(model.near, model.meta.jdsatepoch + model.meta.jdsatepochF);
+		near_index_.push_back(count_);
+	}
+
+	return count_++;
+}
+
+void sgp4_batch_t::propagate(double jd, sgp4_batch_result_t& res) {
+	res.resize(count_);
+
+	double t[SGP4_BATCH_LANES];
+	lanes_out_t out;
+
+	for (size_t base = 0; base < near_.lanes; base += SGP4_BATCH_LANES) {
+		for (int l = 0; l < SGP4_BATCH_LANES; l++) {
+			t[l] = (jd - near_.jdepoch[base + l]) * 1440.0;
+		}
+
+		_propagate_lanes(near_, base, t, out);
+
+		size_t n = std::min((size_t)SGP4_BATCH_LANES, near_.lanes - base);
+		for (size_t l = 0; l < n; l++) {
+			size_t i = near_index_[base + l];
+
+			res.x[i] = out.r[0][l];
+			res.y[i] = out.r[1][l];
+			res.z[i] = out.r[2][l];
+			res.vx[i] = out.v[0][l];
+			res.vy[i] = out.v[1][l];
+			res.vz[i] = out.v[2][l];
+			res.error[i] = out.error[l];
+		}
+	}
+
+	// the sun and moon terms are shared by all the deep space satellites
+	sgp4_lunarsolar ls;
+	if (!deep_.empty())
+		SGP4Funcs::lunarsolarterms(jd, ls);
+
+	for (size_t k = 0; k < deep_.size(); k++) {
+		const sgp4_model& model = deep_[k];
+		sgp4_state& state = deep_state_[k];
+		size_t i = deep_index_[k];
+
+		double r[3], v[3];
+		double tsince = (jd - (model.meta.jdsatepoch + model.meta.jdsatepochF)) * 1440.0;
+		SGP4Funcs::sgp4(model, state, tsince, ls, r, v);
+
+		res.x[i] = r[0];
+		res.y[i] = r[1];
+		res.z[i] = r[2];
+		res.vx[i] = v[0];
+		res.vy[i] = v[1];
+		res.vz[i] = v[2];
+		res.error[i] = state.error;
+	}
+}
+
+void sgp4_batch_t::propagate_grid(const sgp4_model& model, double jd_start, double jd_step, size_t count, sgp4_batch_result_t& res) {
+	double epoch = model.meta.jdsatepoch + model.meta.jdsatepochF;
+	_propagate_dates(model, [jd_start, jd_step, epoch](size_t k) { return (jd_start + (double)k * jd_step - epoch) * 1440.0; }, count, res);
+}
+
+void sgp4_batch_t::propagate_times(const sgp4_model& model, const double* jd, size_t count, sgp4_batch_result_t& res) {
+	double epoch = model.meta.jdsatepoch + model.meta.jdsatepochF;
+	_propagate_dates(model, [jd, epoch](size_t k) { return (jd[k] - epoch) * 1440.0; }, count, res);
+}
+
+void sgp4_batch_t::propagate_minutes(const sgp4_model& model, const double* tsince, size_t count, sgp4_batch_result_t& res) {
+	_propagate_dates(model, [tsince](size_t k) { return tsince[k]; }, count, res);
+}
+
+void sgp4_batch_t::propagate_grid(double jd_start, double jd_step, size_t count, sgp4_batch_result_t& res) {
+	res.resize(count);
+
+	if (!deep_.empty()) {
+		double epoch = deep_[0].meta.jdsatepoch + deep_[0].meta.jdsatepochF;
+		_propagate_deep(deep_[0], deep_state_[0], [jd_start, jd_step, epoch](size_t k) { return (jd_start + (double)k * jd_step - epoch) * 1440.0; }, count, res);
+
+		return;
+	}
+
+	double epoch = near_.jdepoch[0];
+	_propagate_near(near_, [jd_start, jd_step, epoch](size_t k) { return (jd_start + (double)k * jd_step - epoch) * 1440.0; }, count, res);
+}
+
+template <class TS>
+void sgp4_batch_t::_propagate_dates(const sgp4_model& model, TS tsince_at, size_t count, sgp4_batch_result_t& res) {
+	res.resize(count);
+
+	if (model.near.method == 'd') {
+		sgp4_state state{};
+		_propagate_deep(model, state, tsince_at, count, res);
+
+		return;
+	}
+
+	near_soa_t one;
+	one.push(model.near, model.meta.jdsatepoch + model.meta.jdsatepochF);
+	_propagate_near(one, tsince_at, count, res);
+}
+
+template <class TS>
+void sgp4_batch_t::_propagate_deep(const sgp4_model& model, sgp4_state& state, TS tsince_at, size_t count, sgp4_batch_result_t& res) {
+	for (size_t k = 0; k < count; k++) {
+		double r[3], v[3];
+		SGP4Funcs::sgp4(model, state, tsince_at(k), r, v);
+
+		res.x[k] = r[0];
+		res.y[k] = r[1];
+		res.z[k] = r[2];
+		res.vx[k] = v[0];
+		res.vy[k] = v[1];
+		res.vz[k] = v[2];
+		res.error[k] = state.error;
+	}
+}
+
+template <class TS>
+void sgp4_batch_t::_propagate_near(const near_soa_t& one, TS tsince_at, size_t count, sgp4_batch_result_t& res) {
+	// a single satellite fills every lane of the first block, the lanes are used for time instead
+	double t[SGP4_BATCH_LANES];
+	lanes_out_t out;
+
+	for (size_t base = 0; base < count; base += SGP4_BATCH_LANES) {
+		size_t n = std::min((size_t)SGP4_BATCH_LANES, count - base);
+
+		for (size_t l = 0; l < SGP4_BATCH_LANES; l++) {
+			t[l] = tsince_at(base + std::min(l, n - 1));
+		}
+
+		_propagate_lanes(one, 0, t, out);
+
+		for (size_t l = 0; l < n; l++) {
+			size_t k = base + l;
+
+			res.x[k] = out.r[0][l];
+			res.y[k] = out.r[1][l];
+			res.z[k] = out.r[2][l];
+			res.vx[k] = out.v[0][l];
+			res.vy[k] = out.v[1][l];
+			res.vz[k] = out.v[2][l];
+			res.error[k] = out.error[l];
+		}
+	}
+}
+
+// Near earth sgp4 (method 'n') for SGP4_BATCH_LANES lanes starting at base.
+// This follows SGP4Funcs::sgp4 step by step, with the branches replaced by selects. The
+// lane loops are cut at each sine and cosine, computed for all the lanes together by
+// sincos_lanes.
+void sgp4_batch_t::_propagate_lanes(const near_soa_t& s, size_t base, const double t[], lanes_out_t& out) {
+	constexpr int L = SGP4_BATCH_LANES;
+
+	double am[L], nm[L], nodep[L], axnl[L], aynl[L], u[L];
+	double eo1[L], sineo1[L], coseo1[L], tem5[L];
+	double xmdf[L], mm[L], argpm[L], em[L], tempa[L];
+	double sin1[L], cos1[L], sin2[L], cos2[L], sin3[L], cos3[L];
+	double (&r)[3][L] = out.r;
+	double (&v)[3][L] = out.v;
+	int (&error)[L] = out.error;
+
+	/* ------- update for secular gravity and atmospheric drag ----- */
+	for (int l = 0; l < L; l++) {
+		xmdf[l] = s.mo[base + l] + s.mdot[base + l] * t[l];
+	}
+	sincos_lanes(xmdf, sin1, cos1);
+
+	for (int l = 0; l < L; l++) {
+		size_t i = base + l;
+
+		double argpdf = s.argpo[i] + s.argpdot[i] * t[l];
+		double delomg = s.omgcof[i] * t[l];
+		double delmtemp = 1.0 + s.eta[i] * cos1[l];
+		double delm = s.xmcof[i] * (delmtemp * delmtemp * delmtemp - s.delmo[i]);
+		double temp = delomg + delm;
+		mm[l] = xmdf[l] + temp;
+		argpm[l] = argpdf - temp;
+	}
+	sincos_lanes(mm, sin1, cos1);
+
+	for (int l = 0; l < L; l++) {
+		size_t i = base + l;
+
+		double nodedf = s.nodeo[i] + s.nodedot[i] * t[l];
+		double t2 = t[l] * t[l];
+		double t3 = t2 * t[l];
+		double t4 = t3 * t[l];
+		double nodem = nodedf + s.nodecf[i] * t2;
+
+		tempa[l] = 1.0 - s.cc1[i] * t[l] - s.d2[i] * t2 - s.d3[i] * t3 - s.d4[i] * t4;
+		double tempe = s.bstar[i] * s.cc4[i] * t[l] + s.bstar[i] * s.cc5[i] * (sin1[l] - s.sinmao[i]);
+		double templ = s.t2cof[i] * t2 + s.t3cof[i] * t3 + t4 * (s.t4cof[i] + t[l] * s.t5cof[i]);
+
+		double no = s.no_unkozai[i];
+		em[l] = s.ecco[i] - tempe;
+
+		double m = mm[l] + no * templ;
+		double xlm = m + argpm[l] + nodem;
+
+		nodem = fmod_twopi(nodem);
+		argpm[l] = fmod_twopi(argpm[l]);
+		xlm = fmod_twopi(xlm);
+		mm[l] = fmod_twopi(xlm - argpm[l] - nodem);
+
+		nodep[l] = nodem;
+	}
+	sincos_lanes(argpm, sin1, cos1);
+
+	for (int l = 0; l < L; l++) {
+		size_t i = base + l;
+
+		double no = s.no_unkozai[i];
+		bool nm_error = !(no > 0.0);
+
+		double a = std::cbrt(s.xke[i] / no);
+		am[l] = a * a * tempa[l] * tempa[l];
+		nm[l] = s.xke[i] / (am[l] * std::sqrt(am[l]));
+
+		bool em_error = (em[l] >= 1.0) || (em[l] < -0.001);
+		double e = std::max(em[l], 1.0e-6);
+
+		/* -------------------- long period periodics ------------------ */
+		axnl[l] = e * cos1[l];
+		double temp = 1.0 / (am[l] * (1.0 - e * e));
+		aynl[l] = e * sin1[l] + temp * s.aycof[i];
+		double xl = mm[l] + argpm[l] + nodep[l] + temp * s.xlcof[i] * axnl[l];
+
+		u[l] = fmod_twopi(xl - nodep[l]);
+		eo1[l] = u[l];
+		tem5[l] = 1.0;	// every lane takes the first step
+
+		error[l] = nm_error ? 2 : (em_error ? 1 : 0);
+	}
+
+	/* --------------------- solve kepler's equation --------------- */
+	// a lane which converged keeps its values while the others go on, the sine and
+	// cosine of the short periodics are those of its last step, as in sgp4
+	for (int k = 0; k < kepler_iterations; k++) {
+		bool moving = false;
+		for (int l = 0; l < L; l++) {
+			moving |= std::abs(tem5[l]) >= kepler_tolerance;
+		}
+		if (!moving)
+			break;
+
+		sincos_lanes(eo1, sin1, cos1);
+		for (int l = 0; l < L; l++) {
+			bool active = std::abs(tem5[l]) >= kepler_tolerance;
+			double step = 1.0 - cos1[l] * axnl[l] - sin1[l] * aynl[l];
+			step = (u[l] - aynl[l] * cos1[l] + axnl[l] * sin1[l] - eo1[l]) / step;
+			step = std::min(std::max(step, -0.95), 0.95);
+
+			sineo1[l] = active ? sin1[l] : sineo1[l];
+			coseo1[l] = active ? cos1[l] : coseo1[l];
+			eo1[l] = active ? eo1[l] + step : eo1[l];
+			tem5[l] = active ? step : tem5[l];
+		}
+	}
+
+	/* ------------- short period periodics and orientation -------- */
+	double su[L], xnode[L], xinc[L], mrt[L], mvt[L], rvdot[L];
+	for (int l = 0; l < L; l++) {
+		size_t i = base + l;
+
+		double ecose = axnl[l] * coseo1[l] + aynl[l] * sineo1[l];
+		double esine = axnl[l] * sineo1[l] - aynl[l] * coseo1[l];
+		double el2 = axnl[l] * axnl[l] + aynl[l] * aynl[l];
+		double pl = am[l] * (1.0 - el2);
+		bool pl_error = (pl < 0.0);
+
+		double rl = am[l] * (1.0 - ecose);
+		double rdotl = std::sqrt(am[l]) * esine / rl;
+		double rvdotl = std::sqrt(pl) / rl;
+		double betal = std::sqrt(1.0 - el2);
+		double temp = esine / (1.0 + betal);
+		double sinu = am[l] / rl * (sineo1[l] - aynl[l] - axnl[l] * temp);
+		double cosu = am[l] / rl * (coseo1[l] - axnl[l] + aynl[l] * temp);
+		double sin2u = (cosu + cosu) * sinu;
+		double cos2u = 1.0 - 2.0 * sinu * sinu;
+		temp = 1.0 / pl;
+		double temp1 = 0.5 * s.j2[i] * temp;
+		double temp2 = temp1 * temp;
+
+		mrt[l] = rl * (1.0 - 1.5 * temp2 * betal * s.con41[i]) + 0.5 * temp1 * s.x1mth2[i] * cos2u;
+		su[l] = std::atan2(sinu, cosu) - 0.25 * temp2 * s.x7thm1[i] * sin2u;
+		xnode[l] = nodep[l] + 1.5 * temp2 * s.cosio[i] * sin2u;
+		xinc[l] = s.inclo[i] + 1.5 * temp2 * s.cosio[i] * s.sinio[i] * cos2u;
+		mvt[l] = rdotl - nm[l] * temp1 * s.x1mth2[i] * sin2u / s.xke[i];
+		rvdot[l] = rvdotl + nm[l] * temp1 * (s.x1mth2[i] * cos2u + 1.5 * s.con41[i]) / s.xke[i];
+
+		// first error wins, as in sgp4 which returns on the first failed check
+		int err = pl_error ? 4 : ((mrt[l] < 1.0) ? 6 : 0);
+		error[l] = (error[l] != 0) ? error[l] : err;
+	}
+	sincos_lanes(su, sin1, cos1);
+	sincos_lanes(xnode, sin2, cos2);
+	sincos_lanes(xinc, sin3, cos3);
+
+	for (int l = 0; l < L; l++) {
+		size_t i = base + l;
+
+		double xmx = -sin2[l] * cos3[l];
+		double xmy = cos2[l] * cos3[l];
+		double ux = xmx * sin1[l] + cos2[l] * cos1[l];
+		double uy = xmy * sin1[l] + sin2[l] * cos1[l];
+		double uz = sin3[l] * sin1[l];
+		double vx = xmx * cos1[l] - cos2[l] * sin1[l];
+		double vy = xmy * cos1[l] - sin2[l] * sin1[l];
+		double vz = sin3[l] * cos1[l];
+
+		double vkmpersec = s.radiusearthkm[i] * s.xke[i] / 60.0;
+
+		r[0][l] = (mrt[l] * ux) * s.radiusearthkm[i];
+		r[1][l] = (mrt[l] * uy) * s.radiusearthkm[i];
+		r[2][l] = (mrt[l] * uz) * s.radiusearthkm[i];
+		v[0][l] = (mvt[l] * ux + rvdot[l] * vx) * vkmpersec;
+		v[1][l] = (mvt[l] * uy + rvdot[l] * vy) * vkmpersec;
+		v[2][l] = (mvt[l] * uz + rvdot[l] * vz) * vkmpersec;
+	}
+}
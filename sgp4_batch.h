@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "SGP4.h"
+
+// Number of satellites evaluated together by the batch kernel. The kernel is written as
+// branch-free loops over SGP4_BATCH_LANES, the sines and cosines of all the lanes are
+// computed together with SSE2 polynomials (2 lanes per instruction, no math library
+// call), and kepler's equation stops once every lane of the block converged.
+constexpr int SGP4_BATCH_LANES = 8;
+
+// Positions/velocities of a batch, one array per component (TEME, km and km/s)
+struct sgp4_batch_result_t {
+	std::vector<double> x, y, z;
+	std::vector<double> vx, vy, vz;
+	std::vector<int> error;	// same codes as elsetrec::error, 0 when the lane is valid
+
+	void resize(size_t n) {
+		x.resize(n);
+		y.resize(n);
+		z.resize(n);
+		vx.resize(n);
+		vy.resize(n);
+		vz.resize(n);
+		error.resize(n);
+	}
+};
+
+// Batch of satellites propagated to the same instant.
+// Near earth satellites (method 'n') are kept as structure of arrays and evaluated
+// SGP4_BATCH_LANES at a time, deep space satellites fall back to SGP4Funcs::sgp4
+// with the sun and moon terms computed once per date for all of them.
+class sgp4_batch_t {
+public:
+	sgp4_batch_t() = default;
+
+	void clear();
+	void reserve(size_t n);
+
+	// returns the index of the satellite in the batch results
+	size_t add(const elsetrec& satrec);
+	size_t add(const sgp4_model& model);
+
+	size_t size() const {
+		return count_;
+	}
+
+	// propagate every satellite of the batch at the julian date jd
+	void propagate(double jd, sgp4_batch_result_t& res);
+
+	// propagate one satellite over count julian dates, jd_start + k * jd_step
+	// res holds one entry per date, the near earth case is vectorized across time
+	static void propagate_grid(const sgp4_model& model, double jd_start, double jd_step, size_t count, sgp4_batch_result_t& res);
+
+	// propagate one satellite over count arbitrary julian dates
+	static void propagate_times(const sgp4_model& model, const double* jd, size_t count, sgp4_batch_result_t& res);
+
+	// same with the times given in minutes since the satellite epoch, free of the
+	// rounding of julian dates (about 40 us at current dates)
+	static void propagate_minutes(const sgp4_model& model, const double* tsince, size_t count, sgp4_batch_result_t& res);
+
+	// propagate_grid for the satellite of a batch of one, the lanes are built once by add().
+	// A deep space satellite keeps its integrator state from one call to the next
+	void propagate_grid(double jd_start, double jd_step, size_t count, sgp4_batch_result_t& res);
+
+private:
+	struct near_soa_t {
+		// epoch, julian date
+		std::vector<double> jdepoch;
+
+		// secular terms
+		std::vector<double> mo, mdot, argpo, argpdot, nodeo, nodedot, nodecf;
+
+		// drag terms, the isimp != 1 coefficients are zeroed for simplified drag satellites
+		std::vector<double> bstar, cc1, cc4, cc5, t2cof, t3cof, t4cof, t5cof,
+			d2, d3, d4, omgcof, xmcof, eta, delmo, sinmao;
+
+		// mean elements
+		std::vector<double> no_unkozai, ecco, inclo, sinio, cosio;
+
+		// long and short period coefficients
+		std::vector<double> aycof, xlcof, con41, x1mth2, x7thm1;
+
+		// gravity constants
+		std::vector<double> xke, j2, radiusearthkm;
+
+		size_t lanes{};	// satellites stored, the arrays are padded to a multiple of SGP4_BATCH_LANES
+
+		template <class F>
+		void for_each_field(F f) {
+			for (auto* v : { &jdepoch, &mo, &mdot, &argpo, &argpdot, &nodeo, &nodedot, &nodecf,
+							 &bstar, &cc1, &cc4, &cc5, &t2cof, &t3cof, &t4cof, &t5cof,
+							 &d2, &d3, &d4, &omgcof, &xmcof, &eta, &delmo, &sinmao,
+							 &no_unkozai, &ecco, &inclo, &sinio, &cosio,
+							 &aycof, &xlcof, &con41, &x1mth2, &x7thm1,
+							 &xke, &j2, &radiusearthkm }) {
+				f(*v);
+			}
+		}
+
+		void clear();
+		void reserve(size_t n);
+
+		// rec is an elsetrec or an elsetrec_near
+		template <class rec_t>
+		void push(const rec_t& rec, double jd_epoch);
+	};
+
+	struct lanes_out_t {
+		double r[3][SGP4_BATCH_LANES];
+		double v[3][SGP4_BATCH_LANES];
+		int error[SGP4_BATCH_LANES];
+	};
+
+	// near earth sgp4 for the SGP4_BATCH_LANES lanes starting at base, t in minutes since each lane epoch
+	static void _propagate_lanes(const near_soa_t& s, size_t base, const double t[], lanes_out_t& out);
+
+	// tsince_at(k) gives the time of sample k in minutes since epoch
+	template <class TS>
+	static void _propagate_dates(const sgp4_model& model, TS tsince_at, size_t count, sgp4_batch_result_t& res);
+
+	// one satellite over the dates of tsince_at, res already sized : every lane of the
+	// first block of one holds it, or the scalar deep space sgp4 from state
+	template <class TS>
+	static void _propagate_near(const near_soa_t& one, TS tsince_at, size_t count, sgp4_batch_result_t& res);
+
+	template <class TS>
+	static void _propagate_deep(const sgp4_model& model, sgp4_state& state, TS tsince_at, size_t count, sgp4_batch_result_t& res);
+
+	size_t count_{};
+
+	near_soa_t near_;
+	std::vector<size_t> near_index_;	// batch index of each near earth lane
+
+	std::vector<sgp4_model> deep_;
+	std::vector<sgp4_state> deep_state_;
+	std::vector<size_t> deep_index_;	// batch index of each deep space satellite
+};
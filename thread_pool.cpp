@@ -0,0 +1,125 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <exception>
+
+thread_pool_t::thread_pool_t(size_t threads) {
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t i = 0; i < threads; i++) {
+		workers_.emplace_back([this] { _worker(); });
+	}
+}
+
+thread_pool_t::~thread_pool_t() {
+	stop();
+}
+
+void thread_pool_t::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+
+	for (auto& w : workers_) {
+		if (w.joinable())
+			w.join();
+	}
+}
+
+void thread_pool_t::push(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back(std::move(job));
+	}
+	cv_.notify_one();
+}
+
+void thread_pool_t::_worker() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+			if (stop_ && jobs_.empty())
+				return;
+
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+		job();
+	}
+}
+
+void thread_pool_t::parallel_for(size_t count, const std::function<void(size_t, size_t)>& f, size_t min_chunk) {
+	if (count == 0)
+		return;
+
+	// a few chunks per thread so that uneven chunks still balance
+	size_t chunk = std::max(min_chunk, count / ((size() + 1) * 4) + 1);
+	size_t chunks = (count + chunk - 1) / chunk;
+	if (chunks == 1) {
+		f(0, count);
+		return;
+	}
+
+	// chunks are claimed through next, by the caller and by the helper jobs. A helper
+	// that starts after the last claim does nothing : the batch outlives the call for
+	// it, f is only read by the ones that claimed a chunk, before the caller returns.
+	// The first exception of f is kept for the caller, the chunks claimed after it are
+	// counted without running
+	struct batch_t {
+		std::atomic<size_t> next{};
+		std::atomic<bool> failed{};
+		size_t done{};
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable cv;
+	};
+	auto batch = std::make_shared<batch_t>();
+
+	auto run = [batch, fp = &f, count, chunk, chunks] {
+		size_t ran = 0;
+		for (size_t i; (i = batch->next++) < chunks; ran++) {
+			if (batch->failed.load())
+				continue;
+
+			size_t begin = i * chunk;
+			try {
+				(*fp)(begin, std::min(count, begin + chunk));
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(batch->mutex);
+				if (!batch->error)
+					batch->error = std::current_exception();
+				batch->failed = true;
+			}
+		}
+		if (ran == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(batch->mutex);
+		batch->done += ran;
+		if (batch->done == chunks)
+			batch->cv.notify_one();
+	};
+
+	size_t helpers = std::min(size(), chunks - 1);
+	for (size_t i = 0; i < helpers; i++) {
+		push(run);
+	}
+
+	// the caller only runs chunks of this range, never another queued job, then waits
+	// for the chunks still running on the workers
+	run();
+
+	std::unique_lock<std::mutex> lock(batch->mutex);
+	batch->cv.wait(lock, [&] { return batch->done == chunks; });
+
+	if (batch->error)
+		std::rethrow_exception(batch->error);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// Fixed set of worker threads running queued jobs.
+// parallel_for splits an index range in chunks and blocks until all of them are
+// done, the calling thread runs chunks of its own range too so it never waits idle.
+// The owner stops the pool before its code is unloaded : a plugin cannot rely on
+// static destructors, they run under the loader lock and the workers never exit.
+class thread_pool_t {
+public:
+	// threads = 0 : one thread per hardware thread
+	explicit thread_pool_t(size_t threads = 0);
+	~thread_pool_t();
+
+	thread_pool_t(const thread_pool_t&) = delete;
+	thread_pool_t& operator=(const thread_pool_t&) = delete;
+
+	// finishes the queued jobs and joins the workers, the destructor does it too
+	void stop();
+
+	size_t size() const {
+		return workers_.size();
+	}
+
+	void push(std::function<void()> job);
+
+	// f(begin, end) over [0, count), in chunks of at least min_chunk indices. The first
+	// exception thrown by f is thrown again here once all the chunks are finished
+	void parallel_for(size_t count, const std::function<void(size_t, size_t)>& f, size_t min_chunk = 1);
+
+private:
+	void _worker();
+
+	std::vector<std::thread> workers_;
+	std::deque<std::function<void()>> jobs_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	bool stop_{};
+};